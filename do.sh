@@ -1,20 +1,13 @@
 #!/usr/bin/bash
 
-filename="leveldb/table/block.h"
-filename2="leveldb/table/block_builder.h"
+# SLR is chosen per database through Options::block_search_mode,
+# so the same build is used for both runs.
+mode="binary"
 if [ "true" == "$2" ]; then
 	echo "==> SLR True ";
-	search="SLR = false";
-	replace="SLR = true";
-	sed -i "s/$search/$replace/" $filename
-	sed -i "s/$search/$replace/" $filename2
-	
+	mode="slr";
 else
 	echo "==> SLR False ";
-	search="SLR = true";
-	replace="SLR = false";
-	sed -i "s/$search/$replace/" $filename
-	sed -i "s/$search/$replace/" $filename2
 fi 
 
 cd /home/leveldb/leveldb/build
@@ -29,11 +22,11 @@ data=""
 if [ "osm" == "$1" ]; then
 	echo "==> Running OSM ";
 	g++ run.cc -Ileveldb/include -Lleveldb/build -lleveldb -lpthread -lsnappy -o run -g
-	./run 
+	./run $mode
 else
 	echo "==> Running Twitter User Data ";
 	g++ runtwitter.cc -Ileveldb/include -Lleveldb/build -lleveldb -lpthread -lsnappy -o runtwitter -g
-	./runtwitter 
+	./runtwitter $mode
 	data="twitter"
 fi
 
@@ -0,0 +1,367 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "leveldb/comparator.h"
+#include "leveldb/iterator.h"
+#include "leveldb/key_projection.h"
+#include "leveldb/options.h"
+#include "table/block.h"
+#include "table/block_builder.h"
+#include "table/format.h"
+#include "util/coding.h"
+#include "util/piecewise_linear.h"
+#include "util/random.h"
+#include "util/testutil.h"
+
+namespace leveldb {
+
+namespace {
+
+// Restart keys per block; every key is a restart point.
+constexpr int kNumKeys = 1024;
+
+// Returns sorted ordinals that fit "segments" exact linear pieces with
+// alternating slopes, so an SLR model with epsilon 0 needs about that many
+// segments.
+std::vector<uint64_t> MakeOrdinals(int segments) {
+  std::vector<uint64_t> ordinals;
+  uint64_t ordinal = 1000;
+  const int run = kNumKeys / segments;
+  for (int i = 0; i < kNumKeys; i++) {
+    ordinal += ((i / run) % 2 == 0) ? 1 : 1000;
+    ordinals.push_back(ordinal);
+  }
+  return ordinals;
+}
+
+std::string OrdinalKey(uint64_t ordinal) {
+  std::string key(8, '\0');
+  for (int i = 7; i >= 0; i--) {
+    key[i] = static_cast<char>(ordinal & 0xff);
+    ordinal >>= 8;
+  }
+  return key;
+}
+
+// First ordinal of each segment the block model will hold.
+std::vector<uint64_t> SegmentDirectory(const std::vector<uint64_t>& ordinals) {
+  PiecewiseLinearFitter fitter(0);
+  for (uint64_t ordinal : ordinals) {
+    fitter.Add(ordinal);
+  }
+  std::vector<LinearSegment> segments;
+  fitter.Finish(&segments);
+  std::vector<uint64_t> directory;
+  for (const LinearSegment& segment : segments) {
+    directory.push_back(segment.first_key);
+  }
+  return directory;
+}
+
+std::vector<uint64_t> MakeProbes(const std::vector<uint64_t>& ordinals) {
+  Random rnd(301);
+  std::vector<uint64_t> probes;
+  for (int i = 0; i < 4096; i++) {
+    probes.push_back(ordinals[rnd.Uniform(ordinals.size())]);
+  }
+  return probes;
+}
+
+// The segment directory search alone.
+void BM_SegmentDirectory(benchmark::State& state) {
+  const std::vector<uint64_t> directory =
+      SegmentDirectory(MakeOrdinals(state.range(0)));
+  const std::vector<uint64_t> probes = MakeProbes(MakeOrdinals(state.range(0)));
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(CountKeysAtMost(
+        directory.data(), directory.size(), probes[i++ % probes.size()]));
+  }
+  state.counters["segments"] = directory.size();
+}
+
+// The scalar scan over every segment that the directory search replaced.
+void BM_SegmentDirectoryScan(benchmark::State& state) {
+  const std::vector<uint64_t> directory =
+      SegmentDirectory(MakeOrdinals(state.range(0)));
+  const std::vector<uint64_t> probes = MakeProbes(MakeOrdinals(state.range(0)));
+  size_t i = 0;
+  for (auto _ : state) {
+    const uint64_t find = probes[i++ % probes.size()];
+    uint32_t which_segment = 0;
+    for (uint32_t seg = 1; seg < directory.size(); seg++) {
+      if (find >= directory[seg]) {
+        which_segment = seg;
+      }
+    }
+    benchmark::DoNotOptimize(which_segment);
+  }
+  state.counters["segments"] = directory.size();
+}
+
+// A whole Seek in an SLR block, with the share of it spent in the
+// directory search.
+void BM_BlockSeek(benchmark::State& state) {
+  const std::vector<uint64_t> ordinals = MakeOrdinals(state.range(0));
+  const KeyProjection* projection = NewFixedWidthKeyProjection(8);
+  Options options;
+  options.block_restart_interval = 1;
+  options.block_search_mode = kSLRSearch;
+  options.block_search_epsilon = 0;
+  options.key_projection = projection;
+  BlockBuilder builder(&options);
+  for (uint64_t ordinal : ordinals) {
+    builder.Add(OrdinalKey(ordinal), "value");
+  }
+  BlockContents contents;
+  contents.data = builder.Finish();
+  contents.cachable = false;
+  contents.heap_allocated = false;
+  Block block(contents);
+  Iterator* iter = block.NewIterator(BytewiseComparator(), projection);
+
+  const std::vector<uint64_t> directory = SegmentDirectory(ordinals);
+  const std::vector<uint64_t> probes = MakeProbes(ordinals);
+  std::vector<std::string> targets;
+  for (uint64_t probe : probes) {
+    targets.push_back(OrdinalKey(probe));
+  }
+
+  // Time the directory search over the same targets on its own.
+  const int kRounds = 100;
+  size_t sum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < kRounds; r++) {
+    for (uint64_t probe : probes) {
+      sum += CountKeysAtMost(directory.data(), directory.size(), probe);
+    }
+  }
+  const std::chrono::duration<double, std::nano> directory_time =
+      std::chrono::steady_clock::now() - start;
+  benchmark::DoNotOptimize(sum);
+
+  size_t i = 0;
+  const auto seek_start = std::chrono::steady_clock::now();
+  for (auto _ : state) {
+    iter->Seek(targets[i++ % targets.size()]);
+    benchmark::DoNotOptimize(iter->Valid());
+  }
+  const std::chrono::duration<double, std::nano> seek_time =
+      std::chrono::steady_clock::now() - seek_start;
+
+  const double directory_ns = directory_time.count() / (kRounds * probes.size());
+  const double seek_ns = seek_time.count() / state.iterations();
+  state.counters["segments"] = directory.size();
+  state.counters["directory_ns"] = directory_ns;
+  state.counters["directory_share"] = directory_ns / seek_ns;
+  delete iter;
+  delete projection;
+}
+
+// Seeks that move forward by up to state.range(0) keys at a time from
+// the previous one, as in a merge join, in a block searched with mode
+// state.range(1).  Each Seek starts from where the last one ended.
+void BM_MonotoneSeek(benchmark::State& state) {
+  const int kKeys = 4096;
+  const KeyProjection* projection = NewFixedWidthKeyProjection(8);
+  Options options;
+  options.block_search_mode = static_cast<BlockSearchMode>(state.range(1));
+  options.key_projection = projection;
+  BlockBuilder builder(&options);
+  std::vector<std::string> keys;
+  for (int i = 0; i < kKeys; i++) {
+    keys.push_back(OrdinalKey(1000 + 37 * i + i % 7));
+    builder.Add(keys.back(), "value");
+  }
+  BlockContents contents;
+  contents.data = builder.Finish();
+  contents.cachable = false;
+  contents.heap_allocated = false;
+  Block block(contents);
+  Iterator* iter = block.NewIterator(BytewiseComparator(), projection);
+
+  // One pass over the block in ascending order
+  Random rnd(301);
+  std::vector<std::string> targets;
+  for (int i = 0; i < kKeys; i += 1 + rnd.Uniform(state.range(0))) {
+    targets.push_back(keys[i]);
+  }
+
+  size_t i = 0;
+  for (auto _ : state) {
+    iter->Seek(targets[i]);
+    benchmark::DoNotOptimize(iter->Valid());
+    if (++i == targets.size()) {
+      i = 0;
+    }
+  }
+  state.counters["seeks_per_pass"] = targets.size();
+  delete iter;
+  delete projection;
+}
+
+// Key distributions the block search benchmarks build blocks from, as
+// named by test::GenerateKeys().
+const char* const kDistributions[] = {"uniform", "normal",    "lognormal",
+                                      "zipf",    "piecewise", "books",
+                                      "fb",      "osm"};
+
+const char* SearchModeName(BlockSearchMode mode) {
+  switch (mode) {
+    case kBinarySearch:
+      return "binary";
+    case kSLRSearch:
+      return "slr";
+    case kAdaptiveSearch:
+      return "adaptive";
+    case kRadixSplineSearch:
+      return "radixspline";
+  }
+  return "unknown";
+}
+
+// Counts the key comparisons of the iterators it is given to.
+class CountingComparator : public Comparator {
+ public:
+  CountingComparator() : count_(0) {}
+
+  int Compare(const Slice& a, const Slice& b) const override {
+    count_++;
+    return BytewiseComparator()->Compare(a, b);
+  }
+  const char* Name() const override { return BytewiseComparator()->Name(); }
+  void FindShortestSeparator(std::string* start,
+                             const Slice& limit) const override {
+    BytewiseComparator()->FindShortestSeparator(start, limit);
+  }
+  void FindShortSuccessor(std::string* key) const override {
+    BytewiseComparator()->FindShortSuccessor(key);
+  }
+
+  uint64_t count() const { return count_; }
+
+ private:
+  mutable uint64_t count_;
+};
+
+enum BlockOp { kSeekOp, kNextOp, kPrevOp };
+
+// One block of state.range(2) bytes built from consecutive keys of
+// distribution state.range(0), searched with mode state.range(1) and
+// restart interval state.range(3), timing "op": Seek to random keys of
+// the block and just past them, or Next or Prev from a random key,
+// starting over at the other end of the block when the iterator runs off.
+void BlockSearch(benchmark::State& state, BlockOp op) {
+  const char* distribution = kDistributions[state.range(0)];
+  const BlockSearchMode mode = static_cast<BlockSearchMode>(state.range(1));
+  std::vector<uint64_t> ordinals;
+  test::GenerateKeys(distribution, 301, 1 << 16, &ordinals);
+
+  const KeyProjection* projection = NewFixedWidthKeyProjection(8);
+  Options options;
+  options.block_search_mode = mode;
+  options.block_restart_interval = state.range(3);
+  options.key_projection = projection;
+  BlockBuilder builder(&options);
+  const std::string value(16, 'v');
+  std::vector<uint64_t> block_ordinals;
+  const size_t block_size = state.range(2);
+  for (size_t i = ordinals.size() / 2;
+       i < ordinals.size() && builder.CurrentSizeEstimate() < block_size;
+       i++) {
+    builder.Add(OrdinalKey(ordinals[i]), value);
+    block_ordinals.push_back(ordinals[i]);
+  }
+  BlockContents contents;
+  contents.data = builder.Finish();
+  contents.cachable = false;
+  contents.heap_allocated = false;
+  Block block(contents);
+  CountingComparator comparator;
+  Iterator* iter = block.NewIterator(&comparator, projection);
+
+  Random rnd(301);
+  std::vector<std::string> targets;
+  for (int i = 0; i < 4096; i++) {
+    targets.push_back(OrdinalKey(
+        block_ordinals[rnd.Uniform(block_ordinals.size())] + (i % 2)));
+  }
+  iter->Seek(targets[0]);
+
+  size_t i = 0;
+  const uint64_t start_count = comparator.count();
+  for (auto _ : state) {
+    switch (op) {
+      case kSeekOp:
+        iter->Seek(targets[i++ % targets.size()]);
+        break;
+      case kNextOp:
+        iter->Next();
+        if (!iter->Valid()) iter->SeekToFirst();
+        break;
+      case kPrevOp:
+        iter->Prev();
+        if (!iter->Valid()) iter->SeekToLast();
+        break;
+    }
+    benchmark::DoNotOptimize(iter->Valid());
+  }
+
+  state.counters["comparisons"] = benchmark::Counter(
+      comparator.count() - start_count, benchmark::Counter::kAvgIterations);
+  state.counters["keys"] = block_ordinals.size();
+  state.SetLabel(std::string(distribution) + "/" + SearchModeName(mode));
+  delete iter;
+  delete projection;
+}
+
+void BM_BlockSearchSeek(benchmark::State& state) {
+  BlockSearch(state, kSeekOp);
+}
+
+void BM_BlockSearchNext(benchmark::State& state) {
+  BlockSearch(state, kNextOp);
+}
+
+void BM_BlockSearchPrev(benchmark::State& state) {
+  BlockSearch(state, kPrevOp);
+}
+
+// Distribution x search mode x block size x restart interval
+void BlockSearchArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"distribution", "mode", "block_size", "restart_interval"});
+  for (int d = 0; d < static_cast<int>(sizeof(kDistributions) /
+                                       sizeof(kDistributions[0]));
+       d++) {
+    for (int mode : {kBinarySearch, kSLRSearch, kAdaptiveSearch,
+                     kRadixSplineSearch}) {
+      for (int block_size : {4096, 65536}) {
+        for (int restart_interval : {1, 16}) {
+          b->Args({d, mode, block_size, restart_interval});
+        }
+      }
+    }
+  }
+}
+
+BENCHMARK(BM_SegmentDirectory)->RangeMultiplier(4)->Range(1, 256);
+BENCHMARK(BM_SegmentDirectoryScan)->RangeMultiplier(4)->Range(1, 256);
+BENCHMARK(BM_BlockSeek)->RangeMultiplier(4)->Range(1, 256);
+BENCHMARK(BM_MonotoneSeek)
+    ->ArgsProduct({{1, 16, 256}, {kBinarySearch, kSLRSearch,
+                                  kRadixSplineSearch}});
+BENCHMARK(BM_BlockSearchSeek)->Apply(BlockSearchArgs);
+BENCHMARK(BM_BlockSearchNext)->Apply(BlockSearchArgs);
+BENCHMARK(BM_BlockSearchPrev)->Apply(BlockSearchArgs);
+
+}  // namespace
+
+}  // namespace leveldb
+
+BENCHMARK_MAIN();
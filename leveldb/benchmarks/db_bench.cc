@@ -2,19 +2,35 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <vector>
 
+#include "db/dbformat.h"
+#include "db/filename.h"
 #include "leveldb/cache.h"
 #include "leveldb/comparator.h"
 #include "leveldb/db.h"
 #include "leveldb/env.h"
 #include "leveldb/filter_policy.h"
+#include "leveldb/key_projection.h"
 #include "leveldb/write_batch.h"
 #include "port/port.h"
+#include "table/block.h"
+#include "table/format.h"
+#include "util/coding.h"
 #include "util/crc32c.h"
 #include "util/histogram.h"
 #include "util/mutexlock.h"
@@ -33,9 +49,24 @@ using namespace std;
 //      deleterandom  -- delete N keys in random order
 //      readseq       -- read N times sequentially
 //      readreverse   -- read N times in reverse order
+//      readrandomslr -- read N times in random order from the key files,
+//                       or the numbered keys if none are given
+//      readhotslr    -- as readrandomslr, with zipfian key popularity
+//      readmissingslr -- as readrandomslr, for keys just past those drawn
+//                       that are missing
+//      readreverseslr -- read N times in reverse range scans of 100
+//                       entries from random keys
 //      readrandom    -- read N times in random order
 //      readmissing   -- read N missing keys in random order
 //      readhot       -- read N times in random order from 1% section of DB
+//      slrerror      -- SLR or RadixSpline prediction error over the restart
+//                       keys of every data block in the DB
+//      searchmodes   -- copy the DB once per block search mode (binary,
+//                       SLR and RadixSpline) and time the same random
+//                       reads against each copy
+//      restartsweep  -- copy the DB at restart intervals 16 to 128, with
+//                       binary search and with SLR, and report the table
+//                       size and the time of the same random reads for each
 //      seekrandom    -- N random seeks
 //      seekordered   -- N ordered seeks
 //      open          -- cost of opening a DB
@@ -44,6 +75,7 @@ using namespace std;
 //      compact     -- Compact the entire DB
 //      stats       -- Print DB stats
 //      sstables    -- Print sstable info
+//      searchstats -- Print the block search counters
 //      heapprofile -- Dump a heap profile (if supported by this port)
 static const char* FLAGS_benchmarks =
     "fillseq,"
@@ -111,6 +143,24 @@ static int FLAGS_bloom_bits = -1;
 // Common key prefix length.
 static int FLAGS_key_prefix = 0;
 
+// Search mode for newly built blocks: 0 for binary search, 1 for the
+// segmented linear regression model, 2 to choose per block between the
+// model, interpolation search and binary search, 3 for a RadixSpline.
+// Models are fitted over the decimal value of the keys.
+static int FLAGS_slr = 0;
+
+// Largest prediction error, in restart points, allowed by the SLR model
+// and the RadixSpline.
+static int FLAGS_slr_epsilon = -1;
+
+// If true, data blocks with a search model end at large gaps between key
+// ordinals near block_size (see Options::model_block_boundaries).
+static bool FLAGS_model_block_boundaries = false;
+
+// Number of keys between restart points in newly built blocks.
+// (initialized to default value by "main")
+static int FLAGS_block_restart_interval = 0;
+
 // If true, do not destroy the existing database.  If you set this
 // flag and also specify a benchmark that wants a fresh database, that
 // benchmark will fail.
@@ -122,6 +172,29 @@ static bool FLAGS_reuse_logs = false;
 // Use the db with the following name.
 static const char* FLAGS_db = nullptr;
 
+// If non-null, the benchmarks that number their keys 0 to --num - 1 use
+// the key of each number in a sorted set of --num keys drawn from this
+// distribution instead of the number itself: uniform, normal, lognormal,
+// zipf (clusters of keys with zipfian sizes), piecewise (runs of keys
+// with their own density each), or books, fb and osm (gaps between keys
+// shaped like those SOSD datasets).  Fill and read benchmarks then draw
+// from the same keys.
+static const char* FLAGS_key_distribution = nullptr;
+
+// Seed of the generator of --key_distribution.
+static int FLAGS_key_seed = 301;
+
+// If non-null, fillseqslr writes the keys of this file instead of the
+// built-in OSM sample, and the SLR read benchmarks look them up.  Either
+// binary (SOSD: a uint64 count, then that many uint64 keys, little-endian)
+// or text (decimal keys separated by whitespace or commas).  Keys are
+// stored as decimal strings zero-padded to the width of the largest key.
+static const char* FLAGS_keys_file = nullptr;
+
+// If non-null, the SLR read benchmarks look up the keys of this file, in
+// the same formats as --keys_file, instead of those of --keys_file.
+static const char* FLAGS_lookups_file = nullptr;
+
 namespace leveldb {
 
 namespace {
@@ -186,6 +259,9 @@ class RandomGenerator {
   }
 };
 
+// Keys generated for --key_distribution, in order, or null.
+static const std::vector<uint64_t>* g_distribution_keys = nullptr;
+
 class KeyBuffer {
  public:
   KeyBuffer() {
@@ -195,7 +271,16 @@ class KeyBuffer {
   KeyBuffer& operator=(KeyBuffer& other) = delete;
   KeyBuffer(KeyBuffer& other) = delete;
 
+  // Sets the key numbered "k", which is "k" itself unless keys come from
+  // --key_distribution.
   void Set(int k) {
+    if (g_distribution_keys != nullptr) {
+      const std::vector<uint64_t>& keys = *g_distribution_keys;
+      std::snprintf(buffer_ + FLAGS_key_prefix,
+                    sizeof(buffer_) - FLAGS_key_prefix, "%016llu",
+                    static_cast<unsigned long long>(keys[k % keys.size()]));
+      return;
+    }
     std::snprintf(buffer_ + FLAGS_key_prefix,
                   sizeof(buffer_) - FLAGS_key_prefix, "%016d", k);
   }
@@ -206,6 +291,142 @@ class KeyBuffer {
   char buffer_[1024];
 };
 
+// A list of uint64 keys read from a file.  The file is mapped read-only:
+// binary files are used in place, text files are parsed from the mapping
+// in one pass.
+class KeyFile {
+ public:
+  KeyFile() : base_(nullptr), length_(0), binary_(nullptr), size_(0), max_(0) {}
+  KeyFile(const KeyFile&) = delete;
+  KeyFile& operator=(const KeyFile&) = delete;
+  ~KeyFile() { Close(); }
+
+  Status Open(const std::string& fname) {
+    Close();
+    int fd = ::open(fname.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return Status::IOError(fname, std::strerror(errno));
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      return Status::IOError(fname, std::strerror(errno));
+    }
+    length_ = st.st_size;
+    if (length_ > 0) {
+      void* base = ::mmap(nullptr, length_, PROT_READ, MAP_SHARED, fd, 0);
+      if (base == MAP_FAILED) {
+        ::close(fd);
+        length_ = 0;
+        return Status::IOError(fname, std::strerror(errno));
+      }
+      base_ = static_cast<const char*>(base);
+      ::madvise(base, length_, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+
+    if (length_ >= 8 && (length_ - 8) / 8 == DecodeFixed64(base_) &&
+        (length_ - 8) % 8 == 0) {
+      binary_ = base_ + 8;
+      size_ = DecodeFixed64(base_);
+      for (size_t i = 0; i < size_; i++) {
+        max_ = std::max(max_, (*this)[i]);
+      }
+      return Status::OK();
+    }
+    for (size_t i = 0; i < length_;) {
+      const char c = base_[i];
+      if (c >= '0' && c <= '9') {
+        uint64_t key = 0;
+        for (; i < length_ && base_[i] >= '0' && base_[i] <= '9'; i++) {
+          key = key * 10 + (base_[i] - '0');
+        }
+        text_.push_back(key);
+        max_ = std::max(max_, key);
+      } else if (isspace(c) || c == ',') {
+        i++;
+      } else {
+        Close();
+        return Status::Corruption(fname, "not a key file");
+      }
+    }
+    size_ = text_.size();
+    return Status::OK();
+  }
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+  uint64_t max() const { return max_; }
+
+  uint64_t operator[](size_t i) const {
+    return binary_ != nullptr ? DecodeFixed64(binary_ + 8 * i) : text_[i];
+  }
+
+  // Stores in [*begin, *end) the keys thread "tid" of "n" works on.
+  void Shard(int tid, int n, size_t* begin, size_t* end) const {
+    *begin = size_ * tid / n;
+    *end = size_ * (tid + 1) / n;
+  }
+
+ private:
+  void Close() {
+    if (base_ != nullptr) {
+      ::munmap(const_cast<char*>(base_), length_);
+    }
+    base_ = nullptr;
+    length_ = 0;
+    binary_ = nullptr;
+    text_.clear();
+    size_ = 0;
+    max_ = 0;
+  }
+
+  const char* base_;            // Mapping of the whole file
+  size_t length_;
+  const char* binary_;          // Keys of a binary file, or null
+  std::vector<uint64_t> text_;  // Keys of a text file
+  size_t size_;
+  uint64_t max_;                // Largest key
+};
+
+// Draws ranks 0..n-1 with zipfian probabilities, rank 0 the most likely,
+// as YCSB's ZipfianGenerator does.  Draw() only reads the generator, so
+// threads can share one.
+class ZipfianGenerator {
+ public:
+  ZipfianGenerator() : n_(0), theta_(0), alpha_(0), zetan_(0), eta_(0) {}
+
+  // Prepares to draw from "n" ranks, computing zeta(n) in O(n).
+  void Reset(uint64_t n, double theta) {
+    n_ = n;
+    theta_ = theta;
+    alpha_ = 1.0 / (1.0 - theta);
+    zetan_ = 0;
+    for (uint64_t i = 1; i <= n; i++) {
+      zetan_ += 1.0 / std::pow(static_cast<double>(i), theta);
+    }
+    const double zeta2 = 1.0 + 1.0 / std::pow(2.0, theta);
+    eta_ = (1.0 - std::pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetan_);
+  }
+
+  // Returns the rank "u", uniform in [0, 1), falls on.
+  uint64_t Draw(double u) const {
+    const double uz = u * zetan_;
+    if (uz < 1.0) return 0;
+    if (uz < 1.0 + std::pow(0.5, theta_)) return std::min<uint64_t>(1, n_ - 1);
+    const uint64_t rank =
+        static_cast<uint64_t>(n_ * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+    return std::min(rank, n_ - 1);
+  }
+
+ private:
+  uint64_t n_;
+  double theta_;
+  double alpha_;
+  double zetan_;
+  double eta_;
+};
+
 #if defined(__linux)
 static Slice TrimSpace(Slice s) {
   size_t start = 0;
@@ -371,6 +592,7 @@ class Benchmark {
  private:
   Cache* cache_;
   const FilterPolicy* filter_policy_;
+  const KeyProjection* key_projection_;
   DB* db_;
   int num_;
   int value_size_;
@@ -380,6 +602,60 @@ class Benchmark {
   int heap_counter_;
   CountComparator count_comparator_;
   int total_thread_count_;
+  KeyFile keys_;     // From --keys_file
+  KeyFile lookups_;  // From --lookups_file
+  int key_width_;    // Digits of the keys from files
+  std::vector<uint64_t> distribution_keys_;  // From --key_distribution
+  ZipfianGenerator hot_keys_;  // Ranks of the keys readhotslr reads
+
+  // Loads --keys_file and --lookups_file, if given.  Exits on errors.
+  void LoadKeyFiles() {
+    const char* const names[] = {FLAGS_keys_file, FLAGS_lookups_file};
+    KeyFile* const files[] = {&keys_, &lookups_};
+    uint64_t max = 0;
+    for (int i = 0; i < 2; i++) {
+      if (names[i] == nullptr) {
+        continue;
+      }
+      Status s = files[i]->Open(names[i]);
+      if (!s.ok()) {
+        std::fprintf(stderr, "key file error: %s\n", s.ToString().c_str());
+        std::exit(1);
+      }
+      std::fprintf(stdout, "Key file:   %s (%zu keys)\n", names[i],
+                   files[i]->size());
+      max = std::max(max, files[i]->max());
+    }
+    key_width_ = 1;
+    for (; max >= 10; max /= 10) {
+      key_width_++;
+    }
+  }
+
+  // Generates the keys of --key_distribution, if given.  Exits if the
+  // distribution is unknown.
+  void LoadKeyDistribution() {
+    if (FLAGS_key_distribution == nullptr) {
+      return;
+    }
+    if (!test::GenerateKeys(FLAGS_key_distribution, FLAGS_key_seed, FLAGS_num,
+                      &distribution_keys_)) {
+      std::fprintf(stderr, "unknown key distribution '%s'\n",
+                   FLAGS_key_distribution);
+      std::exit(1);
+    }
+    g_distribution_keys = &distribution_keys_;
+    std::fprintf(stdout, "Key distribution: %s (seed %d, %zu keys)\n",
+                 FLAGS_key_distribution, FLAGS_key_seed,
+                 distribution_keys_.size());
+  }
+
+  // Formats "key" in buf[0..20] as a key from a key file.
+  Slice FileKey(uint64_t key, char* buf) const {
+    std::snprintf(buf, 21, "%0*llu", key_width_,
+                  static_cast<unsigned long long>(key));
+    return Slice(buf, std::strlen(buf));
+  }
 
   void PrintHeader() {
     const int kKeySize = 16 + FLAGS_key_prefix;
@@ -465,6 +741,7 @@ class Benchmark {
         filter_policy_(FLAGS_bloom_bits >= 0
                            ? NewBloomFilterPolicy(FLAGS_bloom_bits)
                            : nullptr),
+        key_projection_(NewDecimalKeyProjection()),
         db_(nullptr),
         num_(FLAGS_num),
         value_size_(FLAGS_value_size),
@@ -472,7 +749,8 @@ class Benchmark {
         reads_(FLAGS_reads < 0 ? FLAGS_num : FLAGS_reads),
         heap_counter_(0),
         count_comparator_(BytewiseComparator()),
-        total_thread_count_(0) {
+        total_thread_count_(0),
+        key_width_(1) {
     std::vector<std::string> files;
     g_env->GetChildren(FLAGS_db, &files);
     for (size_t i = 0; i < files.size(); i++) {
@@ -486,13 +764,17 @@ class Benchmark {
   }
 
   ~Benchmark() {
+    g_distribution_keys = nullptr;
     delete db_;
     delete cache_;
     delete filter_policy_;
+    delete key_projection_;
   }
 
   void Run() {
     PrintHeader();
+    LoadKeyFiles();
+    LoadKeyDistribution();
     Open();
 
     const char* benchmarks = FLAGS_benchmarks;
@@ -527,7 +809,8 @@ class Benchmark {
         method = &Benchmark::WriteSeq;
       } else if (name == Slice("fillseqslr")) {
         fresh_db = true;
-        method = &Benchmark::DoWriteSLR;
+        method = keys_.empty() ? &Benchmark::DoWriteSLR
+                               : &Benchmark::WriteKeyFile;
       } else if (name == Slice("fillbatch")) {
         fresh_db = true;
         entries_per_batch_ = 1000;
@@ -552,10 +835,25 @@ class Benchmark {
         method = &Benchmark::ReadSequential;
       } else if (name == Slice("readseqslr")) {
         method = &Benchmark::ReadSequentialSLR;
+        if (!keys_.empty() || !lookups_.empty()) {
+          method = &Benchmark::ReadKeyFile;
+        }
       } else if (name == Slice("readseqslrtwitter")) {
         method = &Benchmark::ReadSequentialSLRTwitter;
+        if (!keys_.empty() || !lookups_.empty()) {
+          method = &Benchmark::ReadKeyFile;
+        }
+      } else if (name == Slice("readrandomslr")) {
+        method = &Benchmark::ReadRandomSLR;
+      } else if (name == Slice("readhotslr")) {
+        hot_keys_.Reset(SLRKeyCount(), kHotKeyTheta);
+        method = &Benchmark::ReadHotSLR;
+      } else if (name == Slice("readmissingslr")) {
+        method = &Benchmark::ReadMissingSLR;
       } else if (name == Slice("readreverse")) {
         method = &Benchmark::ReadReverse;
+      } else if (name == Slice("readreverseslr")) {
+        method = &Benchmark::ReadReverseSLR;
       } else if (name == Slice("readrandom")) {
         method = &Benchmark::ReadRandom;
       } else if (name == Slice("readmissing")) {
@@ -590,6 +888,14 @@ class Benchmark {
         PrintStats("leveldb.stats");
       } else if (name == Slice("sstables")) {
         PrintStats("leveldb.sstables");
+      } else if (name == Slice("searchstats")) {
+        PrintStats("leveldb.block-search-stats");
+      } else if (name == Slice("slrerror")) {
+        PrintModelError();
+      } else if (name == Slice("searchmodes")) {
+        CompareSearchModes();
+      } else if (name == Slice("restartsweep")) {
+        SweepRestartIntervals();
       } else {
         if (!name.empty()) {  // No error message for empty name
           std::fprintf(stderr, "unknown benchmark '%s'\n",
@@ -767,8 +1073,13 @@ class Benchmark {
   void Open() {
     assert(db_ == nullptr);
     Options options;
+    options.key_projection = key_projection_;
+    options.block_search_mode = static_cast<BlockSearchMode>(FLAGS_slr);
+    options.block_search_epsilon = FLAGS_slr_epsilon;
+    options.model_block_boundaries = FLAGS_model_block_boundaries;
+    options.block_restart_interval = FLAGS_block_restart_interval;
+    options.create_if_missing = !FLAGS_use_existing_db;
     // options.env = g_env;
-    // options.create_if_missing = true;
     // options.block_cache = cache_;
     // options.write_buffer_size = FLAGS_write_buffer_size;
     // options.max_file_size = FLAGS_max_file_size;
@@ -899,6 +1210,58 @@ class Benchmark {
 		// }
 		// thread->stats.AddBytes(bytes);
 	  }
+  // fillseqslr with --keys_file: each thread writes its shard of the keys
+  // in batches of 1000.
+  void WriteKeyFile(ThreadState* thread) {
+    static const size_t kBatch = 1000;
+    size_t begin, end;
+    keys_.Shard(thread->tid, thread->shared->total, &begin, &end);
+    WriteBatch batch;
+    int64_t bytes = 0;
+    char buf[21];
+    for (size_t i = begin; i < end; i += kBatch) {
+      batch.Clear();
+      for (size_t j = i; j < end && j < i + kBatch; j++) {
+        const Slice key = FileKey(keys_[j], buf);
+        const std::string value = "value" + key.ToString();
+        batch.Put(key, value);
+        bytes += key.size() + value.size();
+        thread->stats.FinishedSingleOp();
+      }
+      Status s = db_->Write(write_options_, &batch);
+      if (!s.ok()) {
+        std::fprintf(stderr, "put error: %s\n", s.ToString().c_str());
+        std::exit(1);
+      }
+    }
+    thread->stats.AddBytes(bytes);
+  }
+
+  // readseqslr with --lookups_file or --keys_file: each thread looks up
+  // its shard of the keys in file order.
+  void ReadKeyFile(ThreadState* thread) {
+    const KeyFile& lookups = lookups_.empty() ? keys_ : lookups_;
+    size_t begin, end;
+    lookups.Shard(thread->tid, thread->shared->total, &begin, &end);
+    ReadOptions options;
+    std::string value;
+    int64_t bytes = 0;
+    size_t found = 0;
+    char buf[21];
+    for (size_t i = begin; i < end; i++) {
+      const Slice key = FileKey(lookups[i], buf);
+      if (db_->Get(options, key, &value).ok()) {
+        found++;
+        bytes += key.size() + value.size();
+      }
+      thread->stats.FinishedSingleOp();
+    }
+    thread->stats.AddBytes(bytes);
+    char msg[100];
+    std::snprintf(msg, sizeof(msg), "(%zu of %zu found)", found, end - begin);
+    thread->stats.AddMessage(msg);
+  }
+
   void ReadSequential(ThreadState* thread) {
     Iterator* iter = db_->NewIterator(ReadOptions());
     int i = 0;
@@ -1017,6 +1380,107 @@ class Benchmark {
     thread->stats.AddBytes(bytes);
   }
 
+  // Reverse range scans of kReverseScanLength entries from random keys,
+  // which step back through whole restart runs of every block they cross.
+  void ReadReverseSLR(ThreadState* thread) {
+    static const int kReverseScanLength = 100;
+    Iterator* iter = db_->NewIterator(ReadOptions());
+    int64_t bytes = 0;
+    int scans = 0;
+    KeyBuffer key;
+    for (int i = 0; i < reads_;) {
+      key.Set(thread->rand.Uniform(FLAGS_num));
+      iter->Seek(key.slice());
+      if (!iter->Valid()) {
+        iter->SeekToLast();
+        if (!iter->Valid()) break;  // Empty DB
+      }
+      scans++;
+      for (int j = 0; j < kReverseScanLength && i < reads_ && iter->Valid();
+           j++, i++, iter->Prev()) {
+        bytes += iter->key().size() + iter->value().size();
+        thread->stats.FinishedSingleOp();
+      }
+    }
+    delete iter;
+    thread->stats.AddBytes(bytes);
+    char msg[100];
+    std::snprintf(msg, sizeof(msg), "(%d scans)", scans);
+    thread->stats.AddMessage(msg);
+  }
+
+  // Skew of the key ranks readhotslr draws, YCSB's default.
+  static constexpr double kHotKeyTheta = 0.99;
+
+  enum SLRReadPattern { kUniformReads, kHotReads, kMissingReads };
+
+  // Number of keys the random SLR read benchmarks draw from: the lookups
+  // of --lookups_file or --keys_file if given, or else the --num numbered
+  // keys (of --key_distribution, if given).
+  size_t SLRKeyCount() const {
+    const KeyFile& lookups = lookups_.empty() ? keys_ : lookups_;
+    return lookups.empty() ? FLAGS_num : lookups.size();
+  }
+
+  // Stores in *key the key numbered "i" of the SLRKeyCount() keys.
+  void SLRKey(size_t i, std::string* key) const {
+    const KeyFile& lookups = lookups_.empty() ? keys_ : lookups_;
+    if (!lookups.empty()) {
+      char buf[21];
+      const Slice k = FileKey(lookups[i], buf);
+      key->assign(k.data(), k.size());
+    } else {
+      KeyBuffer k;
+      k.Set(i);
+      const Slice slice = k.slice();
+      key->assign(slice.data(), slice.size());
+    }
+  }
+
+  // Point lookups of keys each thread draws on its own from the
+  // SLRKeyCount() keys: uniformly, by zipfian rank (scattered over the key
+  // space, so hot keys are spread across blocks), or uniformly with a "."
+  // appended, which makes a missing key that sorts and projects right
+  // after the one drawn, so the whole search runs and finds nothing.
+  void ReadSLR(ThreadState* thread, SLRReadPattern pattern) {
+    const size_t count = SLRKeyCount();
+    ReadOptions options;
+    std::string key, value;
+    int64_t bytes = 0;
+    int found = 0;
+    for (int i = 0; i < reads_; i++) {
+      size_t k;
+      if (pattern == kHotReads) {
+        const double u = thread->rand.Next() / 2147483647.0;
+        // Scatter the ranks with a multiplicative hash
+        k = (hot_keys_.Draw(u) * 0x9E3779B97F4A7C15ull) % count;
+      } else {
+        k = (static_cast<uint64_t>(thread->rand.Next()) << 31 |
+             thread->rand.Next()) %
+            count;
+      }
+      SLRKey(k, &key);
+      if (pattern == kMissingReads) {
+        key.push_back('.');
+      }
+      if (db_->Get(options, key, &value).ok()) {
+        found++;
+        bytes += key.size() + value.size();
+      }
+      thread->stats.FinishedSingleOp();
+    }
+    thread->stats.AddBytes(bytes);
+    char msg[100];
+    std::snprintf(msg, sizeof(msg), "(%d of %d found)", found, reads_);
+    thread->stats.AddMessage(msg);
+  }
+
+  void ReadRandomSLR(ThreadState* thread) { ReadSLR(thread, kUniformReads); }
+
+  void ReadHotSLR(ThreadState* thread) { ReadSLR(thread, kHotReads); }
+
+  void ReadMissingSLR(ThreadState* thread) { ReadSLR(thread, kMissingReads); }
+
   void ReadRandom(ThreadState* thread) {
     ReadOptions options;
     std::string value;
@@ -1184,6 +1648,282 @@ class Benchmark {
     std::fprintf(stdout, "\n%s\n", stats.c_str());
   }
 
+  // Adds the model error of every data block in table "fname" to the
+  // totals.  Per-block mean and max errors go to the histograms.
+  Status MeasureTableModelError(const std::string& fname,
+                                const KeyProjection* projection, int* blocks,
+                                int* modeled, BlockModelError* total,
+                                Histogram* block_mean, Histogram* block_max) {
+    uint64_t size;
+    Status s = g_env->GetFileSize(fname, &size);
+    if (!s.ok()) {
+      return s;
+    }
+    if (size < Footer::kEncodedLength) {
+      return Status::Corruption(fname, "file is too short to be an sstable");
+    }
+    RandomAccessFile* file;
+    s = g_env->NewRandomAccessFile(fname, &file);
+    if (!s.ok()) {
+      return s;
+    }
+    char footer_space[Footer::kEncodedLength];
+    Slice footer_input;
+    Footer footer;
+    BlockContents index_contents;
+    s = file->Read(size - Footer::kEncodedLength, Footer::kEncodedLength,
+                   &footer_input, footer_space);
+    if (s.ok()) s = footer.DecodeFrom(&footer_input);
+    if (s.ok()) {
+      s = ReadBlock(file, ReadOptions(), footer.index_handle(),
+                    &index_contents);
+    }
+    if (!s.ok()) {
+      delete file;
+      return s;
+    }
+
+    Block index(index_contents);
+    Iterator* iter = index.NewIterator(BytewiseComparator());
+    for (iter->SeekToFirst(); s.ok() && iter->Valid(); iter->Next()) {
+      BlockHandle handle;
+      Slice input = iter->value();
+      BlockContents contents;
+      s = handle.DecodeFrom(&input);
+      if (s.ok()) s = ReadBlock(file, ReadOptions(), handle, &contents);
+      if (!s.ok()) {
+        break;
+      }
+      Block block(contents);
+      BlockModelError error;
+      ++*blocks;
+      if (block.MeasureModelError(projection, &error)) {
+        ++*modeled;
+        total->restarts += error.restarts;
+        total->total += error.total;
+        total->max = std::max(total->max, error.max);
+        block_mean->Add(static_cast<double>(error.total) / error.restarts);
+        block_max->Add(error.max);
+      }
+    }
+    if (s.ok()) s = iter->status();
+    delete iter;
+    delete file;
+    return s;
+  }
+
+  void PrintModelError() {
+    std::vector<std::string> files;
+    Status s = g_env->GetChildren(FLAGS_db, &files);
+    InternalKeyProjection projection(key_projection_);
+    int blocks = 0;
+    int modeled = 0;
+    BlockModelError total;
+    Histogram block_mean, block_max;
+    block_mean.Clear();
+    block_max.Clear();
+    for (size_t i = 0; s.ok() && i < files.size(); i++) {
+      uint64_t number;
+      FileType type;
+      if (ParseFileName(files[i], &number, &type) && type == kTableFile) {
+        s = MeasureTableModelError(std::string(FLAGS_db) + "/" + files[i],
+                                   &projection, &blocks, &modeled, &total,
+                                   &block_mean, &block_max);
+      }
+    }
+    if (!s.ok()) {
+      std::fprintf(stderr, "slrerror: %s\n", s.ToString().c_str());
+      return;
+    }
+    std::fprintf(stdout,
+                 "%-12s : %d of %d blocks have a learned model; %.3f mean, "
+                 "%u max error over %llu restart keys\n",
+                 "slrerror", modeled, blocks,
+                 total.restarts == 0
+                     ? 0.0
+                     : static_cast<double>(total.total) / total.restarts,
+                 total.max, static_cast<unsigned long long>(total.restarts));
+    if (modeled > 0) {
+      std::fprintf(stdout, "Mean error per block:\n%s\n",
+                   block_mean.ToString().c_str());
+      std::fprintf(stdout, "Max error per block:\n%s\n",
+                   block_max.ToString().c_str());
+    }
+  }
+
+  // Copies every entry of the open database into a fresh database at
+  // "dbname" built with "mode" and "restart_interval", compacted into
+  // sorted tables.
+  Status CopyDB(BlockSearchMode mode, int restart_interval,
+                const std::string& dbname, DB** db) {
+    Options options;
+    options.env = g_env;
+    options.create_if_missing = true;
+    options.error_if_exists = true;
+    options.block_cache = cache_;
+    options.write_buffer_size = FLAGS_write_buffer_size;
+    options.max_file_size = FLAGS_max_file_size;
+    options.block_size = FLAGS_block_size;
+    options.block_restart_interval = restart_interval;
+    options.filter_policy = filter_policy_;
+    options.key_projection = key_projection_;
+    options.block_search_mode = mode;
+    options.block_search_epsilon = FLAGS_slr_epsilon;
+    options.model_block_boundaries = FLAGS_model_block_boundaries;
+    DestroyDB(dbname, options);
+    Status s = DB::Open(options, dbname, db);
+    if (!s.ok()) {
+      return s;
+    }
+    Iterator* iter = db_->NewIterator(ReadOptions());
+    WriteBatch batch;
+    for (iter->SeekToFirst(); s.ok() && iter->Valid(); iter->Next()) {
+      batch.Put(iter->key(), iter->value());
+      if (batch.ApproximateSize() >= (1 << 20)) {
+        s = (*db)->Write(WriteOptions(), &batch);
+        batch.Clear();
+      }
+    }
+    if (s.ok()) s = iter->status();
+    if (s.ok()) s = (*db)->Write(WriteOptions(), &batch);
+    delete iter;
+    if (s.ok()) {
+      (*db)->CompactRange(nullptr, nullptr);
+    }
+    return s;
+  }
+
+  // Total size of the table files of database "dbname".
+  uint64_t TableBytes(const std::string& dbname) {
+    std::vector<std::string> files;
+    g_env->GetChildren(dbname, &files);
+    uint64_t total = 0;
+    for (const std::string& file : files) {
+      uint64_t number, size;
+      FileType type;
+      if (ParseFileName(file, &number, &type) && type == kTableFile &&
+          g_env->GetFileSize(dbname + "/" + file, &size).ok()) {
+        total += size;
+      }
+    }
+    return total;
+  }
+
+  // Stores a random sample of up to max(reads_, 1) keys of the open
+  // database in *sample.  Returns false after reporting "name" skipped if
+  // the database is empty.
+  bool SampleKeys(const char* name, std::vector<std::string>* sample) {
+    // Reservoir sample of the keys to read
+    const size_t wanted = std::min(std::max(reads_, 1), 1 << 20);
+    Random rnd(301);
+    Iterator* iter = db_->NewIterator(ReadOptions());
+    uint32_t seen = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next(), seen++) {
+      if (sample->size() < wanted) {
+        sample->push_back(iter->key().ToString());
+      } else if (seen < (1u << 31)) {
+        const uint32_t slot = rnd.Uniform(seen + 1);
+        if (slot < wanted) {
+          (*sample)[slot] = iter->key().ToString();
+        }
+      }
+    }
+    delete iter;
+    if (sample->empty()) {
+      std::fprintf(stdout, "%-12s : skipped (empty database)\n", name);
+      return false;
+    }
+    return true;
+  }
+
+  // Times reads_ random reads of "sample" from "db", stored at "dbname",
+  // and reports them as "name" together with the size of its tables.
+  void TimeSampleReads(DB* db, const std::string& dbname,
+                       const std::vector<std::string>& sample,
+                       const std::string& name) {
+    // Every copy reads the same keys in the same order
+    Random order(301);
+    ReadOptions options;
+    std::string value;
+    int found = 0;
+    Stats stats;
+    for (int i = 0; i < reads_; i++) {
+      if (db->Get(options, sample[order.Uniform(sample.size())], &value).ok()) {
+        found++;
+      }
+      stats.FinishedSingleOp();
+    }
+    stats.Stop();
+
+    char msg[100];
+    std::snprintf(msg, sizeof(msg), "%.1f MB of tables (%d of %d found)",
+                  TableBytes(dbname) / 1048576.0, found, reads_);
+    stats.AddMessage(msg);
+    stats.Report(name);
+  }
+
+  // Reads the same random sample of the database's keys from a copy of it
+  // built with each block search mode, so that the modes are compared on
+  // identical data and lookups.
+  void CompareSearchModes() {
+    std::vector<std::string> sample;
+    if (!SampleKeys("searchmodes", &sample)) {
+      return;
+    }
+
+    struct Mode {
+      BlockSearchMode mode;
+      const char* name;
+    };
+    const Mode kModes[] = {{kBinarySearch, "binary"},
+                           {kSLRSearch, "slr"},
+                           {kRadixSplineSearch, "radixspline"}};
+    for (const Mode& mode : kModes) {
+      const std::string dbname = std::string(FLAGS_db) + "-" + mode.name;
+      DB* db = nullptr;
+      Status s = CopyDB(mode.mode, FLAGS_block_restart_interval, dbname, &db);
+      if (!s.ok()) {
+        std::fprintf(stderr, "searchmodes: %s\n", s.ToString().c_str());
+        delete db;
+        return;
+      }
+      TimeSampleReads(db, dbname, sample,
+                      std::string("searchmodes.") + mode.name);
+      delete db;
+      DestroyDB(dbname, Options());
+    }
+  }
+
+  // Like CompareSearchModes(), over restart intervals from 16 to 128 with
+  // and without SLR: longer restart runs shrink the tables, and the model
+  // is meant to keep them from slowing down reads.
+  void SweepRestartIntervals() {
+    std::vector<std::string> sample;
+    if (!SampleKeys("restartsweep", &sample)) {
+      return;
+    }
+
+    const int kIntervals[] = {16, 32, 64, 128};
+    for (int interval : kIntervals) {
+      for (BlockSearchMode mode : {kBinarySearch, kSLRSearch}) {
+        const std::string name =
+            std::string(mode == kSLRSearch ? "slr" : "binary") + "-" +
+            std::to_string(interval);
+        const std::string dbname = std::string(FLAGS_db) + "-" + name;
+        DB* db = nullptr;
+        Status s = CopyDB(mode, interval, dbname, &db);
+        if (!s.ok()) {
+          std::fprintf(stderr, "restartsweep: %s\n", s.ToString().c_str());
+          delete db;
+          return;
+        }
+        TimeSampleReads(db, dbname, sample, "restartsweep." + name);
+        delete db;
+        DestroyDB(dbname, Options());
+      }
+    }
+  }
+
   static void WriteToFile(void* arg, const char* buf, int n) {
     reinterpret_cast<WritableFile*>(arg)->Append(Slice(buf, n));
   }
@@ -1214,6 +1954,8 @@ int main(int argc, char** argv) {
   FLAGS_max_file_size = leveldb::Options().max_file_size;
   FLAGS_block_size = leveldb::Options().block_size;
   FLAGS_open_files = leveldb::Options().max_open_files;
+  FLAGS_slr_epsilon = leveldb::Options().block_search_epsilon;
+  FLAGS_block_restart_interval = leveldb::Options().block_restart_interval;
   std::string default_db_path;
 
   for (int i = 1; i < argc; i++) {
@@ -1236,6 +1978,16 @@ int main(int argc, char** argv) {
     } else if (sscanf(argv[i], "--reuse_logs=%d%c", &n, &junk) == 1 &&
                (n == 0 || n == 1)) {
       FLAGS_reuse_logs = n;
+    } else if (sscanf(argv[i], "--slr=%d%c", &n, &junk) == 1 && n >= 0 &&
+               n <= leveldb::kRadixSplineSearch) {
+      FLAGS_slr = n;
+    } else if (sscanf(argv[i], "--slr_epsilon=%d%c", &n, &junk) == 1 &&
+               n >= 0) {
+      FLAGS_slr_epsilon = n;
+    } else if (sscanf(argv[i], "--model_block_boundaries=%d%c", &n, &junk) ==
+                   1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_model_block_boundaries = n;
     } else if (sscanf(argv[i], "--num=%d%c", &n, &junk) == 1) {
       FLAGS_num = n;
     } else if (sscanf(argv[i], "--reads=%d%c", &n, &junk) == 1) {
@@ -1250,6 +2002,12 @@ int main(int argc, char** argv) {
       FLAGS_max_file_size = n;
     } else if (sscanf(argv[i], "--block_size=%d%c", &n, &junk) == 1) {
       FLAGS_block_size = n;
+    } else if (sscanf(argv[i], "--block_restart_interval=%d%c", &n, &junk) ==
+                   1 &&
+               n >= 1) {
+      FLAGS_block_restart_interval = n;
+    } else if (sscanf(argv[i], "--key_seed=%d%c", &n, &junk) == 1) {
+      FLAGS_key_seed = n;
     } else if (sscanf(argv[i], "--key_prefix=%d%c", &n, &junk) == 1) {
       FLAGS_key_prefix = n;
     } else if (sscanf(argv[i], "--cache_size=%d%c", &n, &junk) == 1) {
@@ -1260,6 +2018,12 @@ int main(int argc, char** argv) {
       FLAGS_open_files = n;
     } else if (strncmp(argv[i], "--db=", 5) == 0) {
       FLAGS_db = argv[i] + 5;
+    } else if (strncmp(argv[i], "--key_distribution=", 19) == 0) {
+      FLAGS_key_distribution = argv[i] + 19;
+    } else if (strncmp(argv[i], "--keys_file=", 12) == 0) {
+      FLAGS_keys_file = argv[i] + 12;
+    } else if (strncmp(argv[i], "--lookups_file=", 15) == 0) {
+      FLAGS_lookups_file = argv[i] + 15;
     } else {
       std::fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
       std::exit(1);
@@ -94,10 +94,13 @@ static void ClipToRange(T* ptr, V minvalue, V maxvalue) {
 Options SanitizeOptions(const std::string& dbname,
                         const InternalKeyComparator* icmp,
                         const InternalFilterPolicy* ipolicy,
+                        const InternalKeyProjection* iprojection,
                         const Options& src) {
   Options result = src;
   result.comparator = icmp;
   result.filter_policy = (src.filter_policy != nullptr) ? ipolicy : nullptr;
+  result.key_projection =
+      (src.key_projection != nullptr) ? iprojection : nullptr;
   ClipToRange(&result.max_open_files, 64 + kNumNonTableCacheFiles, 50000);
   ClipToRange(&result.write_buffer_size, 64 << 10, 1 << 30);
   ClipToRange(&result.max_file_size, 1 << 20, 1 << 30);
@@ -127,8 +130,10 @@ DBImpl::DBImpl(const Options& raw_options, const std::string& dbname)
     : env_(raw_options.env),
       internal_comparator_(raw_options.comparator),
       internal_filter_policy_(raw_options.filter_policy),
+      internal_key_projection_(raw_options.key_projection),
       options_(SanitizeOptions(dbname, &internal_comparator_,
-                               &internal_filter_policy_, raw_options)),
+                               &internal_filter_policy_,
+                               &internal_key_projection_, raw_options)),
       owns_info_log_(options_.info_log != raw_options.info_log),
       owns_cache_(options_.block_cache != raw_options.block_cache),
       dbname_(dbname),
@@ -509,13 +514,20 @@ Status DBImpl::WriteLevel0Table(MemTable* mem, VersionEdit* edit,
   FileMetaData meta;
   meta.number = versions_->NewFileNumber();
   pending_outputs_.insert(meta.number);
-  Iterator* iter = mem->NewIterator();
   Log(options_.info_log, "Level-0 table #%llu: started",
       (unsigned long long)meta.number);
 
   Status s;
+  Iterator* iter;
   {
     mutex_.Unlock();
+    // No more writes reach "mem", so freeze it into a sorted array that
+    // the table is built from and that reads search until it is dropped.
+    const bool use_model = options_.key_projection != nullptr &&
+                           options_.block_search_mode != kBinarySearch;
+    mem->Freeze(use_model ? options_.key_projection : nullptr,
+                options_.block_search_epsilon);
+    iter = mem->NewIterator();
     s = BuildTable(dbname_, env_, options_, table_cache_, iter, &meta);
     mutex_.Lock();
   }
@@ -1428,6 +1440,38 @@ bool DBImpl::GetProperty(const Slice& property, std::string* value) {
   } else if (in == "sstables") {
     *value = versions_->current()->DebugString();
     return true;
+  } else if (in == "file-locator-stats") {
+    char buf[100];
+    std::snprintf(buf, sizeof(buf), "lookups: %llu mispredicts: %llu\n",
+                  static_cast<unsigned long long>(
+                      versions_->FileLocatorLookups()),
+                  static_cast<unsigned long long>(
+                      versions_->FileLocatorMispredicts()));
+    value->append(buf);
+    return true;
+  } else if (in == "block-search-stats") {
+    BlockSearchStats stats;
+    GetBlockSearchStats(&stats);
+    const double seeks = std::max<uint64_t>(stats.seeks, 1);
+    const double model_seeks = std::max<uint64_t>(stats.model_seeks, 1);
+    char buf[400];
+    std::snprintf(
+        buf, sizeof(buf),
+        "seeks: %llu\n"
+        "binary-seeks: %llu\n"
+        "model-seeks: %llu\n"
+        "interpolation-seeks: %llu\n"
+        "comparisons-per-seek: %.2f\n"
+        "mean-prediction-error: %.2f\n"
+        "fallbacks: %llu\n",
+        static_cast<unsigned long long>(stats.seeks),
+        static_cast<unsigned long long>(stats.binary_seeks),
+        static_cast<unsigned long long>(stats.model_seeks),
+        static_cast<unsigned long long>(stats.interpolation_seeks),
+        stats.comparisons / seeks, stats.prediction_error / model_seeks,
+        static_cast<unsigned long long>(stats.fallbacks));
+    value->append(buf);
+    return true;
   } else if (in == "approximate-memory-usage") {
     size_t total_usage = options_.block_cache->TotalCharge();
     if (mem_) {
@@ -159,6 +159,7 @@ class DBImpl : public DB {
   Env* const env_;
   const InternalKeyComparator internal_comparator_;
   const InternalFilterPolicy internal_filter_policy_;
+  const InternalKeyProjection internal_key_projection_;
   const Options options_;  // options_.comparator == &internal_comparator_
   const bool owns_info_log_;
   const bool owns_cache_;
@@ -210,6 +211,7 @@ class DBImpl : public DB {
 Options SanitizeOptions(const std::string& db,
                         const InternalKeyComparator* icmp,
                         const InternalFilterPolicy* ipolicy,
+                        const InternalKeyProjection* iprojection,
                         const Options& src);
 
 }  // namespace leveldb
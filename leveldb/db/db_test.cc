@@ -16,6 +16,7 @@
 #include "leveldb/cache.h"
 #include "leveldb/env.h"
 #include "leveldb/filter_policy.h"
+#include "leveldb/key_projection.h"
 #include "leveldb/table.h"
 #include "port/port.h"
 #include "port/thread_annotations.h"
@@ -1941,6 +1942,113 @@ TEST_F(DBTest, BloomFilter) {
   delete options.filter_policy;
 }
 
+TEST_F(DBTest, FileLocator) {
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  options.key_projection = NewDecimalKeyProjection();
+  options.block_search_mode = kSLRSearch;
+  options.compression = kNoCompression;
+  options.write_buffer_size = 1 << 20;  // Many small files
+  options.max_file_size = 1 << 20;
+  DestroyAndReopen(&options);
+
+  const int N = 20000;
+  char key[20];
+  for (int i = 0; i < N; i += 2) {
+    std::snprintf(key, sizeof(key), "%09d", i);
+    ASSERT_LEVELDB_OK(Put(key, std::string(1000, 'v')));
+  }
+  db_->CompactRange(nullptr, nullptr);
+  ASSERT_EQ(0, NumTableFilesAtLevel(0));
+  ASSERT_GE(TotalTableFiles(), 8);  // Enough files for a locator
+
+  // Present and missing keys are found through the locator, and each
+  // lies within its error bound.
+  for (int i = 0; i < N; i++) {
+    std::snprintf(key, sizeof(key), "%09d", i);
+    ASSERT_EQ(i % 2 == 0 ? std::string(1000, 'v') : "NOT_FOUND", Get(key));
+  }
+  std::string stats;
+  ASSERT_TRUE(db_->GetProperty("leveldb.file-locator-stats", &stats));
+  unsigned long long lookups, mispredicts;
+  ASSERT_EQ(2, std::sscanf(stats.c_str(), "lookups: %llu mispredicts: %llu",
+                           &lookups, &mispredicts));
+  ASSERT_GE(lookups, N);
+  ASSERT_EQ(0, mispredicts);
+
+  Close();
+  delete options.key_projection;
+}
+
+// Reads the counters of "leveldb.block-search-stats" that are integers.
+static void BlockSearchCounters(DB* db, unsigned long long* seeks,
+                                unsigned long long* binary_seeks,
+                                unsigned long long* model_seeks,
+                                double* comparisons_per_seek) {
+  std::string stats;
+  ASSERT_TRUE(db->GetProperty("leveldb.block-search-stats", &stats));
+  unsigned long long interpolation_seeks;
+  ASSERT_EQ(5, std::sscanf(stats.c_str(),
+                           "seeks: %llu\nbinary-seeks: %llu\n"
+                           "model-seeks: %llu\ninterpolation-seeks: %llu\n"
+                           "comparisons-per-seek: %lf",
+                           seeks, binary_seeks, model_seeks,
+                           &interpolation_seeks, comparisons_per_seek))
+      << stats;
+}
+
+TEST_F(DBTest, BlockSearchStats) {
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  options.key_projection = NewDecimalKeyProjection();
+  options.block_search_mode = kSLRSearch;
+  options.compression = kNoCompression;
+  DestroyAndReopen(&options);
+
+  const int N = 5000;
+  char key[20];
+  for (int i = 0; i < N; i++) {
+    std::snprintf(key, sizeof(key), "%09d", i * 3);
+    ASSERT_LEVELDB_OK(Put(key, "v"));
+  }
+  db_->CompactRange(nullptr, nullptr);
+
+  unsigned long long seeks, binary_seeks, model_seeks;
+  double comparisons_per_seek;
+  BlockSearchCounters(db_, &seeks, &binary_seeks, &model_seeks,
+                      &comparisons_per_seek);
+  for (int i = 0; i < N; i++) {
+    std::snprintf(key, sizeof(key), "%09d", i * 3);
+    ASSERT_EQ("v", Get(key));
+  }
+  unsigned long long seeks2, binary_seeks2, model_seeks2;
+  BlockSearchCounters(db_, &seeks2, &binary_seeks2, &model_seeks2,
+                      &comparisons_per_seek);
+  // Every Get seeks within an index block and a data block, and the
+  // models of the table serve at least the data block seeks.
+  ASSERT_GE(seeks2 - seeks, 2 * N);
+  ASSERT_GE(model_seeks2 - model_seeks, N);
+  ASSERT_GT(comparisons_per_seek, 0);
+
+  // A live iterator's seeks are counted without waiting for it to be
+  // deleted, but for fewer than 64 held back by each of its index and
+  // data block iterators.
+  Iterator* iter = db_->NewIterator(ReadOptions());
+  for (int i = 0; i < N; i++) {
+    std::snprintf(key, sizeof(key), "%09d", i * 3);
+    iter->Seek(key);
+    ASSERT_TRUE(iter->Valid());
+  }
+  unsigned long long seeks3, binary_seeks3, model_seeks3;
+  BlockSearchCounters(db_, &seeks3, &binary_seeks3, &model_seeks3,
+                      &comparisons_per_seek);
+  ASSERT_GE(seeks3 - seeks2, 2 * N - 2 * 64);
+  delete iter;
+
+  Close();
+  delete options.key_projection;
+}
+
 // Multi-threaded test:
 namespace {
 
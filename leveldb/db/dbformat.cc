@@ -96,6 +96,12 @@ void InternalKeyComparator::FindShortSuccessor(std::string* key) const {
   }
 }
 
+size_t InternalKeyComparator::FixedKeyWidth() const {
+  // Every internal key carries an 8-byte sequence number and type
+  const size_t user_width = user_comparator_->FixedKeyWidth();
+  return user_width == 0 ? 0 : user_width + 8;
+}
+
 const char* InternalFilterPolicy::Name() const { return user_policy_->Name(); }
 
 void InternalFilterPolicy::CreateFilter(const Slice* keys, int n,
@@ -114,6 +120,14 @@ bool InternalFilterPolicy::KeyMayMatch(const Slice& key, const Slice& f) const {
   return user_policy_->KeyMayMatch(ExtractUserKey(key), f);
 }
 
+const char* InternalKeyProjection::Name() const {
+  return user_projection_->Name();
+}
+
+uint64_t InternalKeyProjection::ToOrdinal(const Slice& key) const {
+  return user_projection_->ToOrdinal(ExtractUserKey(key));
+}
+
 LookupKey::LookupKey(const Slice& user_key, SequenceNumber s) {
   size_t usize = user_key.size();
   size_t needed = usize + 13;  // A conservative estimate
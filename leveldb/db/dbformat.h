@@ -12,6 +12,7 @@
 #include "leveldb/comparator.h"
 #include "leveldb/db.h"
 #include "leveldb/filter_policy.h"
+#include "leveldb/key_projection.h"
 #include "leveldb/slice.h"
 #include "leveldb/table_builder.h"
 #include "util/coding.h"
@@ -110,6 +111,7 @@ class InternalKeyComparator : public Comparator {
   void FindShortestSeparator(std::string* start,
                              const Slice& limit) const override;
   void FindShortSuccessor(std::string* key) const override;
+  size_t FixedKeyWidth() const override;
 
   const Comparator* user_comparator() const { return user_comparator_; }
 
@@ -128,6 +130,18 @@ class InternalFilterPolicy : public FilterPolicy {
   bool KeyMayMatch(const Slice& key, const Slice& filter) const override;
 };
 
+// Key projection wrapper that converts from internal keys to user keys
+class InternalKeyProjection : public KeyProjection {
+ private:
+  const KeyProjection* const user_projection_;
+
+ public:
+  explicit InternalKeyProjection(const KeyProjection* p)
+      : user_projection_(p) {}
+  const char* Name() const override;
+  uint64_t ToOrdinal(const Slice& key) const override;
+};
+
 // Modules in this directory should keep internal keys wrapped inside
 // the following class instead of plain strings so that we do not
 // incorrectly use string comparisons instead of an InternalKeyComparator.
@@ -3,10 +3,14 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 #include "db/memtable.h"
+
+#include <algorithm>
+
 #include "db/dbformat.h"
 #include "leveldb/comparator.h"
 #include "leveldb/env.h"
 #include "leveldb/iterator.h"
+#include "leveldb/key_projection.h"
 #include "util/coding.h"
 
 namespace leveldb {
@@ -19,11 +23,22 @@ static Slice GetLengthPrefixedSlice(const char* data) {
 }
 
 MemTable::MemTable(const InternalKeyComparator& comparator)
-    : comparator_(comparator), refs_(0), table_(comparator_, &arena_) {}
+    : comparator_(comparator),
+      refs_(0),
+      table_(comparator_, &arena_),
+      frozen_(false),
+      projection_(nullptr) {}
 
 MemTable::~MemTable() { assert(refs_ == 0); }
 
-size_t MemTable::ApproximateMemoryUsage() { return arena_.MemoryUsage(); }
+size_t MemTable::ApproximateMemoryUsage() {
+  size_t usage = arena_.MemoryUsage();
+  if (frozen()) {
+    usage += entries_.capacity() * sizeof(const char*) +
+             model_.segments().size() * sizeof(LinearSegment);
+  }
+  return usage;
+}
 
 int MemTable::KeyComparator::operator()(const char* aptr,
                                         const char* bptr) const {
@@ -71,7 +86,116 @@ class MemTableIterator : public Iterator {
   std::string tmp_;  // For passing to EncodeKey
 };
 
-Iterator* MemTable::NewIterator() { return new MemTableIterator(&table_); }
+// Iterates over the entry array of a frozen memtable.
+class FrozenMemTableIterator : public Iterator {
+ public:
+  explicit FrozenMemTableIterator(const MemTable* mem)
+      : mem_(mem), index_(mem->entries_.size()) {}
+
+  FrozenMemTableIterator(const FrozenMemTableIterator&) = delete;
+  FrozenMemTableIterator& operator=(const FrozenMemTableIterator&) = delete;
+
+  ~FrozenMemTableIterator() override = default;
+
+  bool Valid() const override { return index_ < mem_->entries_.size(); }
+  void Seek(const Slice& k) override {
+    index_ = mem_->FrozenSeek(EncodeKey(&tmp_, k));
+  }
+  void SeekToFirst() override { index_ = 0; }
+  void SeekToLast() override {
+    // An empty memtable leaves the iterator invalid
+    index_ = mem_->entries_.empty() ? 0 : mem_->entries_.size() - 1;
+  }
+  void Next() override {
+    assert(Valid());
+    index_++;
+  }
+  void Prev() override {
+    assert(Valid());
+    // Stepping back from the first entry wraps to an invalid index
+    index_ = index_ == 0 ? mem_->entries_.size() : index_ - 1;
+  }
+  Slice key() const override {
+    return GetLengthPrefixedSlice(mem_->entries_[index_]);
+  }
+  Slice value() const override {
+    Slice key_slice = GetLengthPrefixedSlice(mem_->entries_[index_]);
+    return GetLengthPrefixedSlice(key_slice.data() + key_slice.size());
+  }
+
+  Status status() const override { return Status::OK(); }
+
+ private:
+  const MemTable* const mem_;
+  size_t index_;     // entries_.size() when not valid
+  std::string tmp_;  // For passing to EncodeKey
+};
+
+Iterator* MemTable::NewIterator() {
+  if (frozen()) {
+    return new FrozenMemTableIterator(this);
+  }
+  return new MemTableIterator(&table_);
+}
+
+void MemTable::Freeze(const KeyProjection* projection, int epsilon) {
+  if (frozen()) {
+    return;
+  }
+  Table::Iterator iter(&table_);
+  for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+    entries_.push_back(iter.key());
+  }
+  if (projection != nullptr && !entries_.empty()) {
+    PiecewiseLinearFitter fitter(epsilon);
+    for (const char* entry : entries_) {
+      const uint64_t ordinal =
+          projection->ToOrdinal(GetLengthPrefixedSlice(entry));
+      if (fitter.num_keys() > 0 && ordinal < fitter.last_key()) {
+        break;  // Not monotone over this memtable
+      }
+      fitter.Add(ordinal);
+    }
+    if (fitter.num_keys() == entries_.size()) {
+      std::vector<LinearSegment> segments;
+      fitter.Finish(&segments);
+      model_ = PiecewiseLinearModel(std::move(segments));
+      projection_ = projection;
+    }
+  }
+  frozen_.store(true, std::memory_order_release);
+}
+
+size_t MemTable::FrozenSeek(const char* target) const {
+  const size_t num_entries = entries_.size();
+  size_t left = 0;
+  size_t right = num_entries;
+  if (!model_.empty()) {
+    // The answer is in [low, high] if the entry before the window is
+    // below the target and the entry at its end is not.  Otherwise fall
+    // back to searching every entry.
+    uint32_t error;
+    const size_t prediction = model_.Predict(
+        projection_->ToOrdinal(GetLengthPrefixedSlice(target)), &error);
+    const size_t low = prediction > error ? prediction - error : 0;
+    const size_t high = std::min(num_entries, prediction + error + 1);
+    if ((low == 0 || comparator_(entries_[low - 1], target) < 0) &&
+        (high == num_entries || comparator_(entries_[high], target) >= 0)) {
+      left = low;
+      right = high;
+    }
+  }
+  // Binary search for the first entry in [left, right] at or after target
+  while (left < right) {
+    const size_t mid = left + (right - left) / 2;
+    if (comparator_(entries_[mid], target) < 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return left;
+}
 
 void MemTable::Add(SequenceNumber s, ValueType type, const Slice& key,
                    const Slice& value) {
@@ -101,9 +225,20 @@ void MemTable::Add(SequenceNumber s, ValueType type, const Slice& key,
 
 bool MemTable::Get(const LookupKey& key, std::string* value, Status* s) {
   Slice memkey = key.memtable_key();
-  Table::Iterator iter(&table_);
-  iter.Seek(memkey.data());
-  if (iter.Valid()) {
+  const char* entry = nullptr;
+  if (frozen()) {
+    const size_t index = FrozenSeek(memkey.data());
+    if (index < entries_.size()) {
+      entry = entries_[index];
+    }
+  } else {
+    Table::Iterator iter(&table_);
+    iter.Seek(memkey.data());
+    if (iter.Valid()) {
+      entry = iter.key();
+    }
+  }
+  if (entry != nullptr) {
     // entry format is:
     //    klength  varint32
     //    userkey  char[klength]
@@ -113,7 +248,6 @@ bool MemTable::Get(const LookupKey& key, std::string* value, Status* s) {
     // Check that it belongs to same user key.  We do not check the
     // sequence number since the Seek() call above should have skipped
     // all entries with overly large sequence numbers.
-    const char* entry = iter.key();
     uint32_t key_length;
     const char* key_ptr = GetVarint32Ptr(entry, entry + 5, &key_length);
     if (comparator_.comparator.user_comparator()->Compare(
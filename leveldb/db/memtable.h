@@ -5,16 +5,20 @@
 #ifndef STORAGE_LEVELDB_DB_MEMTABLE_H_
 #define STORAGE_LEVELDB_DB_MEMTABLE_H_
 
+#include <atomic>
 #include <string>
+#include <vector>
 
 #include "db/dbformat.h"
 #include "db/skiplist.h"
 #include "leveldb/db.h"
 #include "util/arena.h"
+#include "util/piecewise_linear.h"
 
 namespace leveldb {
 
 class InternalKeyComparator;
+class KeyProjection;
 class MemTableIterator;
 
 class MemTable {
@@ -62,7 +66,21 @@ class MemTable {
   // Else, return false.
   bool Get(const LookupKey& key, std::string* value, Status* s);
 
+  // Copy the entries into a sorted array of entry pointers, which later
+  // lookups and iterators search instead of the skiplist.  If "projection"
+  // is non-null, also fit a model over the ordinals of the entries' keys
+  // that predicts each entry's position within "epsilon" of it, so lookups
+  // only search a short window.  Iterators created earlier keep using the
+  // skiplist.  Calls after the first have no effect.
+  // REQUIRES: No Add() calls have been made or will be made concurrently
+  // or after this call.
+  void Freeze(const KeyProjection* projection, int epsilon);
+
+  // Returns true iff Freeze() has been called.
+  bool frozen() const { return frozen_.load(std::memory_order_acquire); }
+
  private:
+  friend class FrozenMemTableIterator;
   friend class MemTableIterator;
   friend class MemTableBackwardIterator;
 
@@ -76,10 +94,20 @@ class MemTable {
 
   ~MemTable();  // Private since only Unref() should be used to delete it
 
+  // Returns the index of the first frozen entry at or after the entry
+  // "target".  REQUIRES: frozen()
+  size_t FrozenSeek(const char* target) const;
+
   KeyComparator comparator_;
   int refs_;
   Arena arena_;
   Table table_;
+
+  // Set by Freeze(), after which the fields below are read-only.
+  std::atomic<bool> frozen_;
+  std::vector<const char*> entries_;  // Every entry, in order
+  const KeyProjection* projection_;   // Null if model_ is empty
+  PiecewiseLinearModel model_;        // From key ordinals to entries_ index
 };
 
 }  // namespace leveldb
@@ -49,7 +49,9 @@ class Repairer {
         env_(options.env),
         icmp_(options.comparator),
         ipolicy_(options.filter_policy),
-        options_(SanitizeOptions(dbname, &icmp_, &ipolicy_, options)),
+        iprojection_(options.key_projection),
+        options_(SanitizeOptions(dbname, &icmp_, &ipolicy_, &iprojection_,
+                                 options)),
         owns_info_log_(options_.info_log != options.info_log),
         owns_cache_(options_.block_cache != options.block_cache),
         next_file_number_(1) {
@@ -429,6 +431,7 @@ class Repairer {
   Env* const env_;
   InternalKeyComparator const icmp_;
   InternalFilterPolicy const ipolicy_;
+  InternalKeyProjection const iprojection_;
   const Options options_;
   bool owns_info_log_;
   bool owns_cache_;
@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <utility>
 
 #include "db/filename.h"
 #include "db/log_reader.h"
@@ -13,6 +14,7 @@
 #include "db/memtable.h"
 #include "db/table_cache.h"
 #include "leveldb/env.h"
+#include "leveldb/key_projection.h"
 #include "leveldb/table_builder.h"
 #include "table/merger.h"
 #include "table/two_level_iterator.h"
@@ -31,6 +33,10 @@ static int64_t MaxGrandParentOverlapBytes(const Options* options) {
   return 10 * TargetFileSize(options);
 }
 
+// Levels with fewer files are binary searched in a handful of comparisons,
+// which is cheaper than consulting a file locator.
+static const size_t kMinFilesForLocator = 8;
+
 // Maximum number of bytes in all compacted files.  We avoid expanding
 // the lower level file set of a compaction if it would make the
 // total compaction cover more than this many bytes.
@@ -84,10 +90,12 @@ Version::~Version() {
   }
 }
 
-int FindFile(const InternalKeyComparator& icmp,
-             const std::vector<FileMetaData*>& files, const Slice& key) {
-  uint32_t left = 0;
-  uint32_t right = files.size();
+// Return the smallest index i in [left, right) such that
+// files[i]->largest >= key, or right if there is no such file.
+static uint32_t FindFileInRange(const InternalKeyComparator& icmp,
+                                const std::vector<FileMetaData*>& files,
+                                const Slice& key, uint32_t left,
+                                uint32_t right) {
   while (left < right) {
     uint32_t mid = (left + right) / 2;
     const FileMetaData* f = files[mid];
@@ -104,6 +112,11 @@ int FindFile(const InternalKeyComparator& icmp,
   return right;
 }
 
+int FindFile(const InternalKeyComparator& icmp,
+             const std::vector<FileMetaData*>& files, const Slice& key) {
+  return FindFileInRange(icmp, files, key, 0, files.size());
+}
+
 static bool AfterFile(const Comparator* ucmp, const Slice* user_key,
                       const FileMetaData* f) {
   // null user_key occurs before all keys and is therefore never after *f
@@ -306,8 +319,8 @@ void Version::ForEachOverlapping(Slice user_key, Slice internal_key, void* arg,
     size_t num_files = files_[level].size();
     if (num_files == 0) continue;
 
-    // Binary search to find earliest index whose largest key >= internal_key.
-    uint32_t index = FindFile(vset_->icmp_, files_[level], internal_key);
+    // Find earliest index whose largest key >= internal_key.
+    uint32_t index = LocateFile(level, internal_key);
     if (index < num_files) {
       FileMetaData* f = files_[level][index];
       if (ucmp->Compare(user_key, f->smallest.user_key()) < 0) {
@@ -321,6 +334,44 @@ void Version::ForEachOverlapping(Slice user_key, Slice internal_key, void* arg,
   }
 }
 
+uint32_t Version::LocateFile(int level, const Slice& internal_key) const {
+  const InternalKeyComparator& icmp = vset_->icmp_;
+  const std::vector<FileMetaData*>& files = files_[level];
+  const PiecewiseLinearModel& locator = file_locators_[level];
+  if (locator.empty()) {
+    return FindFile(icmp, files, internal_key);
+  }
+  vset_->file_locator_lookups_.fetch_add(1, std::memory_order_relaxed);
+
+  // Every file's largest key is predicted within "error" of the file, so
+  // a key between the largest keys of two files lands at most one further
+  // from the second of them.
+  const uint32_t num_files = files.size();
+  uint32_t error;
+  const uint32_t prediction = locator.Predict(
+      vset_->options_->key_projection->ToOrdinal(internal_key), &error);
+  const uint32_t low = prediction > error ? prediction - error : 0;
+  const uint32_t high = std::min<uint64_t>(
+      num_files, static_cast<uint64_t>(prediction) + error + 1);
+  const uint32_t index =
+      FindFileInRange(icmp, files, internal_key, low, high);
+
+  // An answer on the edge of the window is confirmed with the file beyond.
+  bool mispredict = false;
+  if (index == low && low > 0) {
+    mispredict =
+        icmp.Compare(files[low - 1]->largest.Encode(), internal_key) >= 0;
+  }
+  if (index == high && high < num_files) {
+    mispredict = icmp.Compare(files[high]->largest.Encode(), internal_key) < 0;
+  }
+  if (mispredict) {
+    vset_->file_locator_mispredicts_.fetch_add(1, std::memory_order_relaxed);
+    return FindFile(icmp, files, internal_key);
+  }
+  return index;
+}
+
 Status Version::Get(const ReadOptions& options, const LookupKey& k,
                     std::string* value, GetStats* stats) {
   stats->seek_file = nullptr;
@@ -746,7 +797,9 @@ VersionSet::VersionSet(const std::string& dbname, const Options* options,
       descriptor_file_(nullptr),
       descriptor_log_(nullptr),
       dummy_versions_(this),
-      current_(nullptr) {
+      current_(nullptr),
+      file_locator_lookups_(0),
+      file_locator_mispredicts_(0) {
   AppendVersion(new Version(this));
 }
 
@@ -1064,6 +1117,38 @@ void VersionSet::Finalize(Version* v) {
 
   v->compaction_level_ = best_level;
   v->compaction_score_ = best_score;
+
+  BuildFileLocators(v);
+}
+
+void VersionSet::BuildFileLocators(Version* v) {
+  const KeyProjection* projection = options_->key_projection;
+  if (projection == nullptr || options_->block_search_mode == kBinarySearch) {
+    return;
+  }
+  for (int level = 1; level < config::kNumLevels; level++) {
+    const std::vector<FileMetaData*>& files = v->files_[level];
+    if (current_ != nullptr && current_->files_[level] == files) {
+      v->file_locators_[level] = current_->file_locators_[level];
+      continue;
+    }
+    if (files.size() < kMinFilesForLocator) {
+      continue;
+    }
+    PiecewiseLinearFitter fitter(options_->block_search_epsilon);
+    for (const FileMetaData* f : files) {
+      const uint64_t ordinal = projection->ToOrdinal(f->largest.Encode());
+      if (fitter.num_keys() > 0 && ordinal < fitter.last_key()) {
+        break;  // Not monotone over this level
+      }
+      fitter.Add(ordinal);
+    }
+    if (fitter.num_keys() == files.size()) {
+      std::vector<LinearSegment> segments;
+      fitter.Finish(&segments);
+      v->file_locators_[level] = PiecewiseLinearModel(std::move(segments));
+    }
+  }
 }
 
 Status VersionSet::WriteSnapshot(log::Writer* log) {
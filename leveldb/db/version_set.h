@@ -15,6 +15,7 @@
 #ifndef STORAGE_LEVELDB_DB_VERSION_SET_H_
 #define STORAGE_LEVELDB_DB_VERSION_SET_H_
 
+#include <atomic>
 #include <map>
 #include <set>
 #include <vector>
@@ -23,6 +24,7 @@
 #include "db/version_edit.h"
 #include "port/port.h"
 #include "port/thread_annotations.h"
+#include "util/piecewise_linear.h"
 
 namespace leveldb {
 
@@ -137,6 +139,11 @@ class Version {
 
   Iterator* NewConcatenatingIterator(const ReadOptions&, int level) const;
 
+  // Like FindFile() on files_[level], but predicts the file with the level's
+  // file locator, if it has one, and searches only the predicted window.
+  // REQUIRES: level > 0
+  uint32_t LocateFile(int level, const Slice& internal_key) const;
+
   // Call func(arg, level, f) for every file that overlaps user_key in
   // order from newest to oldest.  If an invocation of func returns
   // false, makes no more calls.
@@ -153,6 +160,11 @@ class Version {
   // List of files per level
   std::vector<FileMetaData*> files_[config::kNumLevels];
 
+  // Learned models from key ordinals to the index of the file in files_
+  // that may hold the key, one for each sorted level that is large enough
+  // to benefit.  Empty for the other levels.  Built by Finalize().
+  PiecewiseLinearModel file_locators_[config::kNumLevels];
+
   // Next file to compact based on seek stats.
   FileMetaData* file_to_compact_;
   int file_to_compact_level_;
@@ -262,6 +274,16 @@ class VersionSet {
   // "key" as of version "v".
   uint64_t ApproximateOffsetOf(Version* v, const InternalKey& key);
 
+  // Number of lookups in a level that used its file locator, and how many
+  // of them fell outside the locator's error bound and had to search the
+  // whole level.
+  uint64_t FileLocatorLookups() const {
+    return file_locator_lookups_.load(std::memory_order_relaxed);
+  }
+  uint64_t FileLocatorMispredicts() const {
+    return file_locator_mispredicts_.load(std::memory_order_relaxed);
+  }
+
   // Return a human-readable short (single-line) summary of the number
   // of files per level.  Uses *scratch as backing store.
   struct LevelSummaryStorage {
@@ -279,6 +301,10 @@ class VersionSet {
 
   void Finalize(Version* v);
 
+  // Fit the file locators of *v, reusing those of current_ for levels
+  // that did not change.
+  void BuildFileLocators(Version* v);
+
   void GetRange(const std::vector<FileMetaData*>& inputs, InternalKey* smallest,
                 InternalKey* largest);
 
@@ -313,6 +339,10 @@ class VersionSet {
   // Per-level key at which the next compaction at that level should start.
   // Either an empty string, or a valid InternalKey.
   std::string compact_pointer_[config::kNumLevels];
+
+  // Updated by Version::Get() without holding the lock
+  std::atomic<uint64_t> file_locator_lookups_;
+  std::atomic<uint64_t> file_locator_mispredicts_;
 };
 
 // A Compaction encapsulates information about a compaction.
@@ -5,6 +5,7 @@
 #ifndef STORAGE_LEVELDB_INCLUDE_COMPARATOR_H_
 #define STORAGE_LEVELDB_INCLUDE_COMPARATOR_H_
 
+#include <cstddef>
 #include <string>
 
 #include "leveldb/export.h"
@@ -52,6 +53,12 @@ class LEVELDB_EXPORT Comparator {
   // Simple comparator implementations may return with *key unchanged,
   // i.e., an implementation of this method that does nothing is correct.
   virtual void FindShortSuccessor(std::string* key) const = 0;
+
+  // Returns the length of every key this comparator is used with, or 0 if
+  // keys vary in length.  A non-zero width lets tables store their keys in
+  // fixed-width data blocks (see Options::fixed_width_blocks).  Separators
+  // and successors made by the functions above need not have this width.
+  virtual size_t FixedKeyWidth() const { return 0; }
 };
 
 // Return a builtin comparator that uses lexicographic byte-wise
@@ -59,6 +66,14 @@ class LEVELDB_EXPORT Comparator {
 // must not be deleted.
 LEVELDB_EXPORT const Comparator* BytewiseComparator();
 
+// Return a new comparator that orders keys like BytewiseComparator(), and
+// has the same name, but declares that every key is "width" bytes long.
+// Use it for keys such as big-endian integers so that tables can store
+// them in fixed-width data blocks.  The caller must delete the result
+// when it is no longer needed.
+// REQUIRES: width > 0
+LEVELDB_EXPORT Comparator* NewFixedWidthBytewiseComparator(size_t width);
+
 }  // namespace leveldb
 
 #endif  // STORAGE_LEVELDB_INCLUDE_COMPARATOR_H_
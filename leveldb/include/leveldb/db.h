@@ -121,6 +121,17 @@ class LEVELDB_EXPORT DB {
   //     of the sstables that make up the db contents.
   //  "leveldb.approximate-memory-usage" - returns the approximate number of
   //     bytes of memory in use by the DB.
+  //  "leveldb.file-locator-stats" - returns how many lookups used the
+  //     learned file locators of sorted levels, and how many of those the
+  //     locators mispredicted.
+  //  "leveldb.block-search-stats" - returns the seeks within data and index
+  //     blocks, by binary search, search model or interpolation search, the
+  //     key comparisons per seek, the mean distance between a model's
+  //     prediction and the answer, and how many model searches missed
+  //     their window.  The counters are process-wide: they sum the seeks
+  //     of every database the process has opened, not just this one.  They
+  //     also lag live iterators, each of which holds back up to a few
+  //     dozen of its latest seeks until it is deleted.
   virtual bool GetProperty(const Slice& property, std::string* value) = 0;
 
   // For each i in [0,n-1], store in "sizes[i]", the approximate
@@ -0,0 +1,67 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A KeyProjection maps keys to unsigned 64-bit ordinals.  Learned search
+// models (see Options::block_search_mode) are fitted over these ordinals
+// to predict where a key is stored, so the projection should spread keys
+// over the ordinal space in the same order as the comparator.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_KEY_PROJECTION_H_
+#define STORAGE_LEVELDB_INCLUDE_KEY_PROJECTION_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+class Slice;
+
+class LEVELDB_EXPORT KeyProjection {
+ public:
+  virtual ~KeyProjection();
+
+  // The name of the projection.
+  virtual const char* Name() const = 0;
+
+  // Return the ordinal of "key".  The mapping should be monotone with
+  // respect to the comparator: if a < b then ToOrdinal(a) <= ToOrdinal(b).
+  // A projection that is not monotone for some keys never produces wrong
+  // results, but makes lookups of those keys slower.
+  //
+  // Called on every lookup, so implementations should not allocate.
+  virtual uint64_t ToOrdinal(const Slice& key) const = 0;
+};
+
+// Return a new projection for keys that start with an unsigned ASCII
+// decimal number, e.g. "340895854".  Parsing stops at the first
+// non-digit; numbers that do not fit in 64 bits saturate.  With the
+// default bytewise comparator the projection is monotone when all numbers
+// are printed with the same width (zero padded).
+//
+// Callers must delete the result after any database that is using the
+// result has been closed.
+LEVELDB_EXPORT const KeyProjection* NewDecimalKeyProjection();
+
+// Return a new projection for keys that start with a big-endian unsigned
+// integer of "width" bytes, 1 <= width <= 8.  Missing bytes of shorter
+// keys read as zero.
+//
+// Callers must delete the result after any database that is using the
+// result has been closed.
+LEVELDB_EXPORT const KeyProjection* NewFixedWidthKeyProjection(size_t width);
+
+// Return a new projection that interprets the first eight bytes of a key
+// (zero padded) as a big-endian integer.  This is monotone for any keys
+// ordered by the bytewise comparator, e.g. composite or hex string keys,
+// and works best when the keys differ within their first eight bytes.
+//
+// Callers must delete the result after any database that is using the
+// result has been closed.
+LEVELDB_EXPORT const KeyProjection* NewPrefixKeyProjection();
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_KEY_PROJECTION_H_
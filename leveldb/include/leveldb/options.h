@@ -15,6 +15,7 @@ class Cache;
 class Comparator;
 class Env;
 class FilterPolicy;
+class KeyProjection;
 class Logger;
 class Snapshot;
 
@@ -29,6 +30,19 @@ enum CompressionType {
   kSnappyCompression = 0x1
 };
 
+// Each block keeps an array of restart points that is searched to find
+// the region holding a key.  The following enum describes how that search
+// is performed for newly built blocks.  These values are not stored on
+// disk: each block records the type of model it was built with in its
+// trailer, so the mode only controls how new blocks are built and blocks
+// built with different modes can coexist in one database.
+enum BlockSearchMode {
+  kBinarySearch = 0x0,
+  kSLRSearch = 0x1,          // Segmented linear regression over restart keys
+  kAdaptiveSearch = 0x2,     // Whichever search suits each block's keys best
+  kRadixSplineSearch = 0x3,  // RadixSpline over the restart keys
+};
+
 // Options to control the behavior of a database (passed to DB::Open)
 struct LEVELDB_EXPORT Options {
   // Create an Options object with default values for all fields.
@@ -104,6 +118,58 @@ struct LEVELDB_EXPORT Options {
   // leave this parameter alone.
   int block_restart_interval = 16;
 
+  // If true and the comparator declares a fixed key width (see
+  // Comparator::FixedKeyWidth), data blocks store their keys in a dense
+  // array of that width, apart from the values, instead of prefix
+  // compressed between restart points.  A search model then predicts the
+  // entry holding a key rather than a restart point, and no entries are
+  // scanned after it.  Keys take more space without prefix compression.
+  // Index and meta blocks keep the usual format.  Blocks record their
+  // format, so this parameter can be changed dynamically.
+  bool fixed_width_blocks = false;
+
+  // Search used to locate a restart point in newly built blocks.
+  // kSLRSearch stores a segmented linear regression model over the restart
+  // keys in each block and uses it to predict the restart point for a key.
+  // kAdaptiveSearch fits the same model, then keeps it, replaces it with an
+  // interpolation search, or drops it for a binary search, whichever takes
+  // the fewest key comparisons to find the block's own restart keys.
+  // kRadixSplineSearch stores a RadixSpline instead: a linear spline
+  // built in one pass with a radix table over the top bits of its knots.
+  // With any of these modes, tables also get a learned index over their
+  // index block, of the spline kind under kRadixSplineSearch and of the
+  // SLR kind otherwise.  None has any effect unless key_projection is set.
+  // Existing blocks are always searched with the mode they were built with.
+  // This parameter can be changed dynamically.
+  //
+  // Default: kBinarySearch
+  BlockSearchMode block_search_mode = kBinarySearch;
+
+  // Largest distance, in restart points, between the restart point a
+  // kSLRSearch or kRadixSplineSearch model predicts for a restart key and
+  // its true position.  The model gets as many segments as it needs to
+  // meet this bound (up to rounding for a RadixSpline), so smaller values
+  // narrow the search window at the cost of a larger block trailer.
+  // This parameter can be changed dynamically.
+  int block_search_epsilon = 4;
+
+  // If true, tables built with a search model place data block boundaries
+  // where the keys allow: once a block is within an eighth of block_size
+  // of full, it ends early before a key whose ordinal gap from the last
+  // key is several times the block's mean gap, or grows by up to an
+  // eighth of block_size past it until such a gap comes.  Keeping the
+  // breaks of a clustered key distribution between blocks lets each
+  // block's model fit its keys more tightly.  Has no effect unless
+  // block_search_mode and key_projection give blocks a model.  This
+  // parameter can be changed dynamically.
+  bool model_block_boundaries = false;
+
+  // Maps keys to the numeric ordinals that learned search models are
+  // fitted over (see leveldb/key_projection.h).  Blocks carrying a model
+  // are binary searched when this is null.  Use the same projection every
+  // time a database is opened; a different one only slows down lookups.
+  const KeyProjection* key_projection = nullptr;
+
   // Leveldb will write up to this amount of bytes to a file before
   // switching to a new one.
   // Most clients should leave this parameter alone.  However if your
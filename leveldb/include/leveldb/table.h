@@ -14,11 +14,13 @@ namespace leveldb {
 
 class Block;
 class BlockHandle;
+enum BlockModelType : uint8_t;
 class Footer;
 struct Options;
 class RandomAccessFile;
 struct ReadOptions;
 class TableCache;
+struct TableModelStats;
 
 // A Table is a sorted map from strings to strings.  Tables are
 // immutable and persistent.  A Table may be safely accessed from
@@ -58,6 +60,12 @@ class LEVELDB_EXPORT Table {
   // be close to the file length.
   uint64_t ApproximateOffsetOf(const Slice& key) const;
 
+  // If the table's data blocks carry search models, stores in *stats the
+  // distribution of their prediction errors recorded when the table was
+  // built, and returns true.  Returns false if the table has no such
+  // record or was opened without Options::key_projection.
+  bool GetModelStats(TableModelStats* stats) const;
+
  private:
   friend class TableCache;
   struct Rep;
@@ -75,6 +83,9 @@ class LEVELDB_EXPORT Table {
 
   void ReadMeta(const Footer& footer);
   void ReadFilter(const Slice& filter_handle_value);
+  void ReadIndexModel(BlockModelType type,
+                      const Slice& index_model_handle_value);
+  void ReadModelStats(const Slice& model_stats_handle_value);
 
   Rep* const rep_;
 };
@@ -7,221 +7,182 @@
 #include "table/block.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
-#include <vector>
-
-#include <fstream>
-#include <sstream>
+#include <limits>
 #include <string>
-
+#include <utility>
+#include <vector>
 
 #include "leveldb/comparator.h"
+#include "leveldb/key_projection.h"
+#include "port/port.h"
+#include "port/thread_annotations.h"
 #include "table/format.h"
+#include "table/interpolation_search.h"
 #include "util/coding.h"
 #include "util/logging.h"
-#include <typeinfo>
-
-#include<iostream>
-using namespace std;
+#include "util/mutexlock.h"
+#include "util/no_destructor.h"
+#include "util/piecewise_linear.h"
+#include "util/radix_spline.h"
 
 namespace leveldb {
 
 inline uint32_t Block::NumRestarts() const {
   assert(size_ >= sizeof(uint32_t));
-  
-  /*
-  cout << "data_ : " << data_ << endl;
-  cout << "sizeof(uint32_t) : " << sizeof(uint32_t) << endl;
-  cout << "size : " << size_ << endl;
-  cout << "sblm decode : " << data_ + size_ - sizeof(uint32_t) << endl;
-  
-  if(size_ == 4121 && sizeof(uint32_t) == 4){
-	  cout << "aku 1900 " << endl;
-  }
-  
-  printf("Car %c \n", data_ + size_ - sizeof(uint32_t));
-  
-  //char a = 'B';
-	//const char *b = new char(a);
-	
-	// std::string s;
-	  // for (uint32_t v = 0; v < 50; v++) {
-		// PutFixed32(&s, v);
-	  // }
-	  
-	  // cout << "ber " << s << endl;
-
-	  // const char* p = s.data();
-	  // for (uint32_t v = 0; v < 50; v++) {
-		// uint32_t actual = DecodeFixed32(p);
-		// // ASSERT_EQ(v, actual);
-		// cout << " v " << v << " act " << actual << " p " << p << endl; 
-		// p += sizeof(uint32_t);
-	  // }
-	 // printf(sizeof(uint32_t));
-	// uint32_t a = data_ + 1900; 
-	const char *b = data_ + size_ - sizeof(uint32_t);
-	
-	
-	const char *s = b;
-	std::string str(s);
-	// int a = atoi(data_);
-	cout << "a : " << s << endl;
-	
-	// const char *b =data_ + 1900; 
-	// unsigned int vIn = 1900;
-	// char b [11];
-	// _ultoa_s(vIn,b,sizeof(b),10);
-	
-	if(size_ == 1908 && sizeof(uint32_t) == 4){
-		const char *cstr = data_ + size_ - 4;
-		cout << "babukaw" << DecodeFixed32(cstr) << endl;
-		// size_ =size_ - sizeof(uint32_t)
-	}
-	
-	if(size_ == 1909 && sizeof(uint32_t) == 4){
-		string strx = "B" ;
-		// const char *cstr = &strx[0]; 
-		const char *cstr = data_ + 4121 - 4;
-		// const char *cstr2 = 4121 - 4;
-		const char *cstr2 = "NAK"; 
-		
-		int d = atol(cstr);
-		printf("tol %d\n", d);
-		
-		printf("val %d \n", d);
-		printf("Carx %c \n", cstr);
-		printf("Carxx %c \n", data_);
-		printf("Carxxx %c \n", cstr2);
-		// uint32_t cstr = data_ + 1900; 
-		// std::ifstream file(cstr, std::ios_base::binary);
-		std::ifstream file(data_, std::ios_base::binary);
-		std::ostringstream buffer;
-		buffer << file.rdbuf();
-		// return buffer.str();
-		
-		cout << "buffer : " << buffer.str() << endl;
-		cout << "cstr : " << cstr << endl;
-		printf("cstrhex %02hhx \n", data_);
-		cout << "cstrx : " << b << endl;
-		
-		// const char *b ='1900'; 
-		
-		cout << "sizeb : " << b << endl;
-		cout << "babuk" << DecodeFixed32(cstr) << endl;
-	}
-	printf("cstrhex %02hhx \n", data_);
-	printf("cstrhex %02hhx \n", size_);
-	printf("cstrhex %02hhx \n", sizeof(uint32_t));
-	printf("cstrhex %02hhx \n", data_ + size_ - sizeof(uint32_t));
-	cout << "sss : " << data_ + size_ - sizeof(uint32_t) << endl;
-	// if(size_ == 1903){
-		// return DecodeFixed32(data_ + size_ - sizeof(uint32_t) - sizeof(uint32_t));
-	// }
-	*/
-	
-  // return DecodeFixed32(data_ + size_ - sizeof(uint32_t));
-  return DecodeFixed32(data_ + size_ - sizeof(uint32_t));
-}
-
-//function to help determine the meta location
-inline uint32_t Block::MetaPosition(int type,int pos) const {
-	int ret = new_meta_size + 1 - type - (3 * (pos-1));
-	
-	// cout << "Metapos " << type << " => " << pos <<" => " << ret << endl;
-	// return pos * sizeof(uint32_t);
-	return ret * sizeof(uint32_t);
-}
-
-
- //fill constant of LR dividend
-inline uint32_t Block::Dividend(int pos) const {
-  assert(size_ >= sizeof(uint32_t));
-  // return DecodeFixed32(data_ + size_ - sizeof(uint32_t) - sizeof(uint32_t));
-  return DecodeFixed32(data_ + size_ - MetaPosition(1,pos));
-}
-
- //fill LR Divisor 
-inline uint32_t Block::Divisor(int pos) const {
-  assert(size_ >= sizeof(uint32_t));
-  // return DecodeFixed32(data_ + size_ - sizeof(uint32_t) - sizeof(uint32_t) - sizeof(uint32_t));
-  // return DecodeFixed32(data_ + size_ - MetaPosition(new_meta_size -pos));
-  return DecodeFixed32(data_ + size_ - MetaPosition(2,pos));
-  // return GetLengthPrefixedSlice(data_ + size_ - sizeof(uint32_t) - sizeof(uint32_t) - sizeof(uint32_t));
-}
-
- //fill LR lowest subset
-inline uint32_t Block::Lowest(int pos) const {
-  assert(size_ >= sizeof(uint32_t));
-  // return DecodeFixed32(data_ + size_ - sizeof(uint32_t) - sizeof(uint32_t) - sizeof(uint32_t));
-  // return DecodeFixed32(data_ + size_ - MetaPosition(new_meta_size + 1 -pos));
-  return DecodeFixed32(data_ + size_ - MetaPosition(3,pos));
-  // return GetLengthPrefixedSlice(data_ + size_ - sizeof(uint32_t) - sizeof(uint32_t) - sizeof(uint32_t));
+  return DecodeFixed32(data_ + size_ - sizeof(uint32_t)) &
+         ~(kBlockModelFlag | kBlockFixedWidthFlag);
 }
 
+// The search model of a block, decoded once when the block is loaded so
+// that blocks served from the block cache do not pay for it on every Seek.
+class Block::Model {
+ public:
+  // Returns the model of type "type" encoded in "input" for a block with
+  // "num_restarts" restart points, or nullptr if "input" is invalid.
+  // REQUIRES: type is kSLRModel, kInterpolationModel or kRadixSplineModel
+  static Model* Decode(BlockModelType type, const Slice& input,
+                       uint32_t num_restarts) {
+    Model* model = new Model(type, num_restarts);
+    bool ok;
+    if (type == kSLRModel) {
+      std::vector<LinearSegment> segments;
+      ok = DecodeSLRModel(input, num_restarts, &segments);
+      model->slr_ = PiecewiseLinearModel(std::move(segments));
+    } else if (type == kRadixSplineModel) {
+      std::vector<SplinePoint> knots;
+      int radix_bits;
+      uint32_t max_error;
+      ok = DecodeRadixSplineModel(input, num_restarts, &knots, &radix_bits,
+                                  &max_error);
+      if (ok) {
+        model->spline_ =
+            RadixSplineModel(std::move(knots), radix_bits, max_error);
+      }
+    } else {
+      ok = DecodeInterpolationModel(input, &model->first_ordinal_,
+                                    &model->last_ordinal_);
+    }
+    if (!ok) {
+      delete model;
+      return nullptr;
+    }
+    return model;
+  }
 
-//function to help determine the meta location
-static inline const uint32_t MetaPos(int type,int pos) {
-	int ret = 33 - type - (3 * (pos-1));
-	return ret * sizeof(uint32_t);
-}
+  BlockModelType type() const { return type_; }
 
-//function to call the dividend value
-static inline const uint32_t DividendMeta(const char* data_, size_t size_, int pos) {
-  assert(size_ >= sizeof(uint32_t));
-  return DecodeFixed32(data_ + size_ - MetaPos(1,pos));
-}
+  // Returns true iff the model predicts restart points, so that Seek
+  // searches only the window around the prediction.
+  bool predicts() const {
+    return type_ == kSLRModel || type_ == kRadixSplineModel;
+  }
 
-//function to call the divisor value
-static inline const uint32_t DivisorMeta(const char* data_, size_t size_, int pos) {
-  assert(size_ >= sizeof(uint32_t));
-  return DecodeFixed32(data_ + size_ - MetaPos(2,pos));
-}
+  // Returns the bytes of memory the model takes.
+  size_t ApproximateMemoryUsage() const {
+    return sizeof(Model) + slr_.ApproximateMemoryUsage() +
+           spline_.ApproximateMemoryUsage();
+  }
 
-//function to call the lowest value
-static inline const uint32_t LowestMeta(const char* data_, size_t size_, int pos) {
-  assert(size_ >= sizeof(uint32_t));
-  return DecodeFixed32(data_ + size_ - MetaPos(3,pos));
-}
+  // Ordinals of the first and last restart keys.
+  // REQUIRES: type() == kInterpolationModel
+  uint64_t first_ordinal() const { return first_ordinal_; }
+  uint64_t last_ordinal() const { return last_ordinal_; }
 
-//function to call the segment size value
-static inline const uint32_t SegmentSize(const char* data_, size_t size_, int pos) {
-  assert(size_ >= sizeof(uint32_t));
-  return DecodeFixed32(data_ + size_ - (2 * sizeof(uint32_t)));
-}
+  // Returns the restart point predicted for a key with ordinal "find", and
+  // stores in *max_error how far the prediction can be from a restart key.
+  // REQUIRES: predicts()
+  uint32_t Predict(uint64_t find, uint32_t* max_error) const {
+    const uint32_t prediction = type_ == kSLRModel
+                                    ? slr_.Predict(find, max_error)
+                                    : spline_.Predict(find, max_error);
+    return std::min(prediction, num_restarts_ - 1);
+  }
 
+ private:
+  Model(BlockModelType type, uint32_t num_restarts)
+      : type_(type),
+        num_restarts_(num_restarts),
+        first_ordinal_(0),
+        last_ordinal_(0) {}
 
+  const BlockModelType type_;
+  const uint32_t num_restarts_;
+  PiecewiseLinearModel slr_;
+  RadixSplineModel spline_;
+  uint64_t first_ordinal_;
+  uint64_t last_ordinal_;
+};
 
 Block::Block(const BlockContents& contents)
     : data_(contents.data.data()),
       size_(contents.data.size()),
+      key_width_(0),
+      model_(nullptr),
       owned_(contents.heap_allocated) {
-		  
-		  // cout << "Block::Block sizeb : " << size_ << endl;
-		  // cout << "contents.data.size() : " << contents.data.size() << endl;
   if (size_ < sizeof(uint32_t)) {
     size_ = 0;  // Error marker
+    return;
+  }
+  const uint32_t flags = DecodeFixed32(data_ + size_ - sizeof(uint32_t));
+  const bool has_model = (flags & kBlockModelFlag) != 0;
+  size_t model_size = 0;
+  uint8_t model_type = 0;
+  if (has_model) {
+    const size_t trailer_size = sizeof(uint32_t) + kBlockModelTrailerSize;
+    if (size_ < trailer_size) {
+      size_ = 0;  // The size is too small for the model trailer
+      return;
+    }
+    model_type = static_cast<uint8_t>(data_[size_ - trailer_size + 4]);
+    model_size = DecodeFixed32(data_ + size_ - trailer_size);
+    if (model_size > size_ - trailer_size) {
+      size_ = 0;  // The size is too small for the model
+      return;
+    }
+    model_size += kBlockModelTrailerSize;
+  }
+  if ((flags & kBlockFixedWidthFlag) != 0) {
+    // The key width sits before the model and the entry count
+    const size_t tail_size = model_size + 2 * sizeof(uint32_t);
+    if (size_ < tail_size) {
+      size_ = 0;  // The size is too small for the key width
+      return;
+    }
+    key_width_ = DecodeFixed32(data_ + size_ - tail_size);
+    if (key_width_ == 0 ||
+        NumRestarts() > (size_ - tail_size) /
+                            (sizeof(uint32_t) + uint64_t{key_width_})) {
+      // The size is too small for the keys and value offsets
+      size_ = 0;
+      return;
+    }
+    restart_offset_ = size_ - tail_size - NumRestarts() * sizeof(uint32_t);
   } else {
-    size_t max_restarts_allowed = (size_ - sizeof(uint32_t)) / sizeof(uint32_t);
-    if (NumRestarts() > max_restarts_allowed) {
+    if (NumRestarts() >
+        (size_ - sizeof(uint32_t) - model_size) / sizeof(uint32_t)) {
       // The size is too small for NumRestarts()
       size_ = 0;
-    } else {
-      // restart_offset_ = size_ - (1 + NumRestarts()) * sizeof(uint32_t);
-	  
-	  //size of new metas
-      restart_offset_ = size_ - (new_meta_size + NumRestarts()) * sizeof(uint32_t);
-	  
-	  // cout << "rsize " << size_ << endl;
-	  // cout << "(1 + NumRestarts()) " << 1 + NumRestarts() << endl;
-	  // cout << "sizeof(uint32_t) " << sizeof(uint32_t) << endl;
-	  // cout << "restart_offset_ " << restart_offset_ << endl;
-	  // cout << "wow " << (1 + NumRestarts()) * sizeof(uint32_t) << endl;
+      return;
+    }
+    restart_offset_ =
+        size_ - model_size - (1 + NumRestarts()) * sizeof(uint32_t);
+  }
+  if (model_type == kSLRModel || model_type == kInterpolationModel ||
+      model_type == kRadixSplineModel) {
+    const Slice model(data_ + size_ - sizeof(uint32_t) - model_size,
+                      model_size - kBlockModelTrailerSize);
+    model_ = Model::Decode(static_cast<BlockModelType>(model_type), model,
+                           NumRestarts());
+    if (model_ == nullptr) {
+      size_ = 0;  // Bad model
     }
   }
 }
 
 Block::~Block() {
+  delete model_;
   if (owned_) {
     delete[] data_;
   }
@@ -256,8 +217,39 @@ static inline const char* DecodeEntry(const char* p, const char* limit,
   return p;
 }
 
+// Share of a restart run, just before where the run's restart keys place
+// a seek target, whose entries are still compared with the target.
+static const double kRunSkipMargin = 0.125;
+
+// Restart runs that seem to hold fewer entries than this, judging by the
+// size of their restart entry, are compared from their start: skipping
+// into a short run, such as the single entry of an index block's run,
+// saves next to nothing and often lands past the target.
+static const uint32_t kMinSkipRunEntries = 16;
+
+// Block iterators made without caller stats add their own to the thread's
+// counters after this many seeks, so that the seeks of long-lived
+// iterators, such as those over index blocks, do not wait for them to be
+// deleted.
+static const uint64_t kSearchStatsFlushSeeks = 64;
+
+static void MaybeFlushSearchStats(BlockSearchStats* own_stats) {
+  if (own_stats->seeks >= kSearchStatsFlushSeeks) {
+    RecordBlockSearchStats(*own_stats);
+    *own_stats = BlockSearchStats();
+  }
+}
+
 class Block::Iter : public Iterator {
  private:
+  // An entry of the restart run that Prev() last decoded.
+  struct RunEntry {
+    uint32_t offset;      // Offset in data_ of the entry
+    uint32_t key_offset;  // Offset in run_keys_ of its key
+    uint32_t key_size;
+    Slice value;
+  };
+
   const Comparator* const comparator_;
   const char* const data_;       // underlying block contents
   uint32_t const restarts_;      // Offset of restart array (list of fixed32)
@@ -266,39 +258,25 @@ class Block::Iter : public Iterator {
   // current_ is offset in data_ of current entry.  >= restarts_ if !Valid
   uint32_t current_;
   uint32_t restart_index_;  // Index of restart block in which current_ falls
-  uint32_t dividend_;  // LR Dividend Variable
-  uint32_t lowest_;  // LR Lowest Subset Variable
-  uint32_t size_;  // LR Lowest Subset Variable
+  const Model* const model_;  // Search model, or nullptr for binary search
+  const KeyProjection* const projection_;  // Set iff model_ is set
+  BlockSearchStats own_stats_;  // Counts when the caller passes no stats
+  BlockSearchStats* const stats_;  // The caller's stats or &own_stats_
   std::string key_;
   Slice value_;
   Status status_;
-  bool slr_;
-  bool debug_;
-  
-  
+
+  // The entries before the current one in its restart run, and their keys,
+  // so that Prev() within the run decodes nothing.  run_index_ is the
+  // current entry's index in run_entries_, or -1 if they are not cached.
+  std::vector<RunEntry> run_entries_;
+  std::string run_keys_;
+  int run_index_;
 
   inline int Compare(const Slice& a, const Slice& b) const {
+    stats_->comparisons++;
     return comparator_->Compare(a, b);
   }
-  
-  inline int CompareInt(const Slice& a, const Slice& b) const {
-	std::string a_string= a.ToString();
-	int a_int= stoi(a_string);
-	
-	string b_string= b.ToString();
-	int b_int= stoi(b_string);
-	
-	cout << "mkki " << a_int << endl;
-	cout << "tkki " << b_int << endl;
-	cout << "a_int - b_int " << a_int - b_int << endl;
-	
-	if(a_int == b_int){
-		return 0;
-	}else {
-		return a_int - b_int;
-	}
-	
-  }
 
   // Return the offset in data_ just past the end of the current entry.
   inline uint32_t NextEntryOffset() const {
@@ -307,36 +285,13 @@ class Block::Iter : public Iterator {
 
   uint32_t GetRestartPoint(uint32_t index) {
     assert(index < num_restarts_);
-	
-	// cout << "GetRestartPoint data_ " << data_ << endl;
-	// cout << "GetRestartPoint restarts_ " << restarts_ << endl;
-	// cout << "GetRestartPoint index " << index  << endl;
-	// cout << "GetRestartPoint index * sizeof(uint32_t) " << index * sizeof(uint32_t)  << endl;
-	// cout << "GetRestartPoint restarts_1 " << restarts_ + index * sizeof(uint32_t)<< endl;
-	// cout << "GetRestartPoint restarts_2 " << data_ + restarts_ + index * sizeof(uint32_t) << endl;
-	
-	// printf("Apa %02x \n", data_ + restarts_ + index * sizeof(uint32_t));
-	// printf("wow cari restartpoint ");
-	
-	const char *cursor = data_ + restarts_ + index * sizeof(uint32_t) ; 
-	  // printf("string: %s\nhex: ", string);
-	// const char* cp = data_;
-	// for ( ; *cp != '\0'; ++cp )
-	// {
-	   // printf("%02x", *cp);
-	// }
-	  // printf("\n");
-	
-    // return DecodeFixed32(cursor);
     return DecodeFixed32(data_ + restarts_ + index * sizeof(uint32_t));
   }
 
   void SeekToRestartPoint(uint32_t index) {
     key_.clear();
-	
+    run_index_ = -1;
     restart_index_ = index;
-	
-	// cout << "restart_index_1 :" << restart_index_ << endl;
     // current_ will be fixed by ParseNextKey();
 
     // ParseNextKey() starts at the end of value_, so set value_ accordingly
@@ -345,33 +300,26 @@ class Block::Iter : public Iterator {
   }
 
  public:
-  // Iter(const Comparator* comparator, const char* data, uint32_t restarts,uint32_t num_restarts)
-  // Iter(const Comparator* comparator, const char* data, uint32_t restarts,uint32_t num_restarts, uint32_t dividend, float lowest, size_t size)
-  Iter(const Comparator* comparator, const char* data, uint32_t restarts,uint32_t num_restarts,  size_t size, bool SLR, bool debug)
-  // Iter(const Comparator* comparator, const char* data, uint32_t restarts,uint32_t num_restarts,  size_t size, bool SLR, bool debug)
+  Iter(const Comparator* comparator, const char* data, uint32_t restarts,
+       uint32_t num_restarts, const Model* model,
+       const KeyProjection* projection, BlockSearchStats* stats)
       : comparator_(comparator),
         data_(data),
         restarts_(restarts),
         num_restarts_(num_restarts),
         current_(restarts_),
         restart_index_(num_restarts_),
-		// dividend_(dividend),
-		// lowest_(lowest),
-		size_(size){
+        model_(model),
+        projection_(projection),
+        stats_(stats != nullptr ? stats : &own_stats_),
+        run_index_(-1) {
     assert(num_restarts_ > 0);
-	
-	// if(debug){
-		// cout << "num_restarts_xxxx :" << num_restarts_ << endl;
-		// // cout << "dividend_ :" << dividend_ << endl;
-		// // cout << "lowest_ :" << lowest_ << endl;
-		// cout << "ukuranku :" << size_ << endl;
-		// cout << "SLR" << SLR << endl;
-		// cout << "debug" << debug << endl;
-	// }
-	
-	slr_=SLR;
-	debug_=debug;
-	
+  }
+
+  ~Iter() override {
+    if (stats_ == &own_stats_) {
+      RecordBlockSearchStats(own_stats_);
+    }
   }
 
   bool Valid() const override { return current_ < restarts_; }
@@ -393,6 +341,15 @@ class Block::Iter : public Iterator {
   void Prev() override {
     assert(Valid());
 
+    if (run_index_ > 0) {
+      // The previous entry is in the same run, and was decoded already
+      const RunEntry& entry = run_entries_[--run_index_];
+      current_ = entry.offset;
+      key_.assign(run_keys_.data() + entry.key_offset, entry.key_size);
+      value_ = entry.value;
+      return;
+    }
+
     // Scan backwards to a restart point before current_
     const uint32_t original = current_;
     while (GetRestartPoint(restart_index_) >= original) {
@@ -404,295 +361,115 @@ class Block::Iter : public Iterator {
       }
       restart_index_--;
     }
-	
-	
-	// cout << "restart_index_2 :" << restart_index_ << endl;
 
     SeekToRestartPoint(restart_index_);
-    do {
-      // Loop until end of current entry hits the start of original entry
-    } while (ParseNextKey() && NextEntryOffset() < original);
+    run_entries_.clear();
+    run_keys_.clear();
+    while (ParseNextKey()) {
+      run_entries_.push_back(
+          RunEntry{current_, static_cast<uint32_t>(run_keys_.size()),
+                   static_cast<uint32_t>(key_.size()), value_});
+      run_keys_.append(key_);
+      if (NextEntryOffset() >= original) {
+        // The end of the current entry hits the start of original entry
+        run_index_ = run_entries_.size() - 1;
+        return;
+      }
+    }
   }
 
-	// Binary search and Segmented Linear Regression search
-	// Get the pre-determined coefficient and use it to predict the position
-	// Use and call the correct segment data only.
+  // Binary search, Segmented Linear Regression search, RadixSpline search
+  // and interpolation search, as chosen by the block's model.  With an SLR
+  // model or a RadixSpline, predict the restart point from the target's
+  // ordinal and search only the window the model's error bound allows,
+  // clamped to the side of the current key the target lies on.
   void Seek(const Slice& target) override {
-    // Binary search in restart array to find the last restart point
-    // with a key < target
-	
-	std::string togot= target.ToString();
+    // Find the last restart point with a key < target
     uint32_t left = 0;
     uint32_t right = num_restarts_ - 1;
     int current_key_compare = 0;
-	
-	// if(debug_){
-		// cout << "Restart Index: " << restart_index_ << endl;
-		// cout << "dividend seek: " << dividend_ << endl;
-		// cout << "lowest_ seek: " << lowest_ << endl;
-	// }
-	
-	// if SLR is active 
-	// and the data is quite big
-	if(restart_index_ > 50 && slr_ ){
-		uint32_t find =  stoi(togot);
-		uint32_t iteration;
-		uint32_t lowestMeta=LowestMeta(data_,size_,1);
-		int which_segment = 1;
-		
-		int segment_len = 10;
-		for(int seg=1; seg <= segment_len; seg ++){
-			iteration=LowestMeta(data_,size_,seg);
-			if(find >= iteration){
-				which_segment=seg;
-				lowestMeta = iteration;
-			} 
-			
-		}
-		
-		// call the metas
-		uint32_t dividendMeta=DividendMeta(data_,size_,which_segment);
-		uint32_t divisorMeta=DivisorMeta(data_,size_,which_segment);
-		uint32_t segmentSize=SegmentSize(data_,size_,which_segment);
-		uint32_t low_index= segmentSize * (which_segment-1);
-		
-		float coef= dividendMeta / divisorMeta;
-		
-		// if(debug_){
-			// cout << "Restart Index: " << restart_index_ << endl;
-			// cout << "segmentSize: "<< segmentSize << "\n";
-			// cout << "which_segment: "<< which_segment << "\n";
-			// cout << "dividendMeta: "<< dividendMeta << "\n";
-			// cout << "divisorMeta: "<< divisorMeta << "\n";
-			// cout << "lowestMeta: "<< lowestMeta << "\n";
-			// cout << "low_index: "<< low_index << "\n";
-			// cout << "$$!------------------" << endl;
-			// cout << "coef: " << coef << endl;
-			// cout << "find: "<< find << "\n";
-			// cout << "lowest_: "<< lowest_ << "\n";
-		// }
-		
-		//prediction formulas
-		int atas = find - lowestMeta;
-		float prediksi2 = atas/coef + low_index;
-		int prediksi = prediksi2;
-		
-		// if(debug_){
-			// cout << "Find: "<< find << "\n";
-			// cout << "Dividend: "<< atas << " (Find-helper)\n";
-			// cout << "Divisor: "<< coef << "\n";
-			
-			// cout << "Prediction int: "<< prediksi << "\n";
-			// cout << "Prediction: "<< prediksi2 << "\n\n";
-		// }
-		
-		// if prediction is lower then 0
-		// we assume it as 0
-		if(prediksi < 0){
-			prediksi=0;
-		}
-		
-		//First Comparison
-		//find restart point first val
-		uint32_t region_offset = GetRestartPoint(prediksi);
-		uint32_t shared, non_shared, value_length;
-		
-		const char* key_ptr =
-		  DecodeEntry(data_ + region_offset, data_ + restarts_, &shared,
-					  &non_shared, &value_length);
-		if (key_ptr == nullptr || (shared != 0)) {
-			CorruptionError();
-			return;
-		}
-		Slice mid_key(key_ptr, non_shared);
-		
-		int cmp=Compare(mid_key, target);
-		string mkk= mid_key.ToString();
-		string tkk= target.ToString();
-		
-		// if(debug_){
-			// cout << "CMP " << cmp << endl;
-			// cout << "mkk " << mkk << endl;
-			// cout << "tkk " << tkk << endl;
-		// }
-		// int tot=1;
-		
-		if (cmp < 0) {
-		
-			//the left side isn't interesting
-			int max = prediksi + 10;
-			if(max >= restart_index_){
-				max= restart_index_ - 1;
-			}
-			for(int b= prediksi+1 ; b <= max; b++){
-				//checking inside
-				uint32_t region_offset_in = GetRestartPoint(b);
-				uint32_t shared_in, non_shared_in, value_length_in;
-				
-				const char* key_ptr_in =
-				  DecodeEntry(data_ + region_offset_in, data_ + restarts_, &shared_in,
-							  &non_shared_in, &value_length_in);
-				if (key_ptr_in == nullptr || (shared_in != 0)) {
-					CorruptionError();
-					return;
-				}
-				Slice mid_key_in(key_ptr_in, non_shared_in);
-				
-				// if(debug_){
-					// cout << "CMP " << Compare(mid_key_in,target) << endl;
-					// tot++;
-					// cout << "b " << b << endl;
-					// cout << "mid_key_in " << mid_key_in.ToString() << endl;
-				// }
-				
-				if (Compare(mid_key_in, target) > 0) {
-					
-					left = b;
-					break;
-				}
-				
-				//checking inside
-				
-		  }
-		} else {
-			//right side isn't interesting
-			int max = prediksi - 10;
-			if(max < 0){
-				max= 0;
-			}
-			for(int b= prediksi - 1; b >= max; b--){
-				//checking inside
-				uint32_t region_offset_in = GetRestartPoint(b);
-				uint32_t shared_in, non_shared_in, value_length_in;
-				
-				const char* key_ptr_in =
-				  DecodeEntry(data_ + region_offset_in, data_ + restarts_, &shared_in,
-							  &non_shared_in, &value_length_in);
-				if (key_ptr_in == nullptr || (shared_in != 0)) {
-					CorruptionError();
-					return;
-				}
-				Slice mid_key_in(key_ptr_in, non_shared_in);
-				
-				int cmp=Compare(mid_key_in, target);
-				
-				// if(debug_){
-					// cout << "CMP " << cmp << endl;
-					// tot++;
-				// }
-				if (Compare(mid_key_in, target) < 0) {
-					
-					left = b;
-					break;
-				}
-				
-				//checking inside
-			}
-		}
-		
-		// if(debug_){
-			// cout << "------------------!## TOT: " << tot << endl; 
-			// cout << find << "," << tot << endl; 
-		// }
-		
-		
-	}else{
-		 // binary search part
-		//original
-		if (Valid()) {
-		  // If we're already scanning, use the current position as a starting
-		  // point. This is beneficial if the key we're seeking to is ahead of the
-		  // current position.
-		  current_key_compare = Compare(key_, target);
-		  if (current_key_compare < 0) {
-			// key_ is smaller than target
-			left = restart_index_;
-		  } else if (current_key_compare > 0) {
-			right = restart_index_;
-		  } else {
-			 // cout << "we are here " << endl;
-			// We're seeking to the key we're already at.
-			return;
-		  }
-		}
-		// int tot=0;
-		while (left < right) {
-		  uint32_t mid = (left + right + 1) / 2;
-		  uint32_t region_offset = GetRestartPoint(mid);
-		  uint32_t shared, non_shared, value_length;
-		  // uint32_t wax = data_ + region_offset;
-		  // uint32_t wax2 = data_ + restarts_;
-		  const char* key_ptr =
-			  DecodeEntry(data_ + region_offset, data_ + restarts_, &shared,
-						  &non_shared, &value_length);
-		  if (key_ptr == nullptr || (shared != 0)) {
-			CorruptionError();
-			return;
-		  }
-		  Slice mid_key(key_ptr, non_shared);
-		  
-		  int cmp=Compare(mid_key, target);
-				
-		  if (Compare(mid_key, target) < 0) {
-		  // if (cmp < 0) {
-			// Key at "mid" is smaller than "target".  Therefore all
-			// blocks before "mid" are uninteresting.
-			left = mid;
-		  } else {
-			// Key at "mid" is >= "target".  Therefore all blocks at or
-			// after "mid" are uninteresting.
-			right = mid - 1;
-		  }
-		  
-		  // tot++;
-		  // if(debug_){
-				// std::string skey= mid_key.ToString();
-			  // cout << "<!***************" << endl;
-			  // cout << "mid " << mid << endl;
-			  // cout << "CMP " << cmp << endl;
-			  // // cout << "wax " << wax << endl;
-			  // // cout << "wax2 " << wax2 << endl;
-			  // cout << "data_ " << data_ << endl;
-			  // cout << "restarts_ " << restarts_ << endl;
-			  // cout << "region_offset " << region_offset << endl;
-			  // cout << "mid_key " << skey << endl;
-			  // cout << "key_ptr " << key_ptr << endl;
-			  // cout << "togot " << togot << endl;
-			  // cout << "left " << left << endl;
-			  // cout << "right " << right << endl;
-			  // cout << "***************!>" << endl;
-			// }
-		  
-		}
-		
-		//original
-	}
-
-    
+    if (stats_ == &own_stats_) MaybeFlushSearchStats(&own_stats_);
+    stats_->seeks++;
+
+    if (model_ != nullptr && model_->predicts()) {
+      stats_->model_seeks++;
+      if (Valid()) {
+        // As below, the current position bounds the search, and a target
+        // in the current restart run is found from the current key on.
+        current_key_compare = Compare(key_, target);
+        if (current_key_compare < 0) {
+          left = restart_index_;
+        } else if (current_key_compare > 0) {
+          right = restart_index_;
+        } else {
+          return;
+        }
+      }
+      if (!SearchModel(target, left, right, &left)) {
+        return;
+      }
+    } else if (model_ != nullptr) {
+      stats_->interpolation_seeks++;
+      if (!SearchInterpolation(target, &left)) {
+        return;
+      }
+    } else {
+      stats_->binary_seeks++;
+      if (Valid()) {
+        // If we're already scanning, use the current position as a starting
+        // point. This is beneficial if the key we're seeking to is ahead of
+        // the current position.
+        current_key_compare = Compare(key_, target);
+        if (current_key_compare < 0) {
+          // key_ is smaller than target
+          left = restart_index_;
+        } else if (current_key_compare > 0) {
+          right = restart_index_;
+        } else {
+          // We're seeking to the key we're already at.
+          return;
+        }
+      }
+      if (!BinarySearch(target, &left, right)) {
+        return;
+      }
+    }
+
     // We might be able to use our current position within the restart block.
     // This is true if we determined the key we desire is in the current block
     // and is after than the current key.
     assert(current_key_compare == 0 || Valid());
     bool skip_seek = left == restart_index_ && current_key_compare < 0;
+    uint32_t compare_from = 0;
     if (!skip_seek) {
-		
-		
       SeekToRestartPoint(left);
+      if (model_ != nullptr && !PredictRunOffset(target, left, &compare_from)) {
+        return;
+      }
     }
-	
-    // Linear search (within restart block) for first key >= target
-	int lp=1;
+    // Linear search (within restart block) for first key >= target.
+    // Entries that start before compare_from are decoded but not compared.
+    bool skipped = false;
     while (true) {
-		
       if (!ParseNextKey()) {
-		
         return;
       }
-	  
-	  
+      if (current_ < compare_from) {
+        skipped = true;
+        stats_->skipped++;
+        continue;
+      }
       if (Compare(key_, target) >= 0) {
-        return;
+        if (!skipped) {
+          return;
+        }
+        // The first key compared is already past the target, which may
+        // be among the skipped entries.
+        stats_->rescans++;
+        SeekToRestartPoint(left);
+        compare_from = 0;
       }
+      skipped = false;
     }
   }
 
@@ -709,16 +486,247 @@ class Block::Iter : public Iterator {
   }
 
  private:
+  // Stores the key at restart point "index" in *key, and the size of its
+  // entry in *entry_size if non-null.  Returns false after flagging
+  // corruption if the entry is bad.
+  bool DecodeRestartKey(uint32_t index, Slice* key,
+                        uint32_t* entry_size = nullptr) {
+    uint32_t region_offset = GetRestartPoint(index);
+    uint32_t shared, non_shared, value_length;
+    const char* key_ptr =
+        DecodeEntry(data_ + region_offset, data_ + restarts_, &shared,
+                    &non_shared, &value_length);
+    if (key_ptr == nullptr || (shared != 0)) {
+      CorruptionError();
+      return false;
+    }
+    *key = Slice(key_ptr, non_shared);
+    if (entry_size != nullptr) {
+      *entry_size = (key_ptr + non_shared + value_length) -
+                    (data_ + region_offset);
+    }
+    return true;
+  }
+
+  // Like DecodeRestartKey(), for a key about to be compared with a target.
+  bool RestartKey(uint32_t index, Slice* key) {
+    if (!DecodeRestartKey(index, key)) {
+      return false;
+    }
+    stats_->probes++;
+    return true;
+  }
+
+  // Stores in *compare_from the offset of the first entry of the run at
+  // restart point "index" that Seek() should compare with "target", or
+  // leaves it at 0 to compare them all.  The target is placed within the
+  // run by interpolating its ordinal between those of the run's restart
+  // key and the next one, and the run's entries are assumed to take about
+  // the same space each; the guess is pulled back by kRunSkipMargin of the
+  // run so that a slight misplacement still lands before the target.
+  // Runs of fewer than about kMinSkipRunEntries entries are left alone.
+  // Returns false after flagging corruption if a restart entry is bad.
+  bool PredictRunOffset(const Slice& target, uint32_t index,
+                        uint32_t* compare_from) {
+    if (index + 1 >= num_restarts_) {
+      return true;  // The last run has no upper key
+    }
+    const uint32_t start = GetRestartPoint(index);
+    const uint32_t limit = GetRestartPoint(index + 1);
+    Slice low_key, high_key;
+    uint32_t entry_size;
+    if (!DecodeRestartKey(index, &low_key, &entry_size)) {
+      return false;
+    }
+    // The restart entry holds the whole key, so it is usually the largest
+    // of its run, and the run holds at least about this many entries.
+    if (limit - start < kMinSkipRunEntries * entry_size) {
+      return true;
+    }
+    if (!DecodeRestartKey(index + 1, &high_key)) {
+      return false;
+    }
+    const uint64_t find = projection_->ToOrdinal(target);
+    const uint64_t low = projection_->ToOrdinal(low_key);
+    const uint64_t high = projection_->ToOrdinal(high_key);
+    if (find <= low || find >= high) {
+      return true;
+    }
+    const double fraction = static_cast<double>(find - low) /
+                                static_cast<double>(high - low) -
+                            kRunSkipMargin;
+    if (fraction > 0) {
+      *compare_from = start + static_cast<uint32_t>(fraction * (limit - start));
+    }
+    return true;
+  }
+
+  // Compares the key at restart point "index" with "target" and stores the
+  // result in *cmp.  Returns false after flagging corruption if the entry
+  // is bad.
+  bool CompareRestartKey(uint32_t index, const Slice& target, int* cmp) {
+    Slice key;
+    if (!RestartKey(index, &key)) {
+      return false;
+    }
+    *cmp = Compare(key, target);
+    return true;
+  }
+
+  // Moves *left up to the last restart point in [*left, right] with a key
+  // < target.  REQUIRES: *left is 0 or has a key < target, and every
+  // restart point after right has a key >= target.
+  bool BinarySearch(const Slice& target, uint32_t* left, uint32_t right) {
+    while (*left < right) {
+      uint32_t mid = (*left + right + 1) / 2;
+      int cmp;
+      if (!CompareRestartKey(mid, target, &cmp)) {
+        return false;
+      }
+      if (cmp < 0) {
+        // Key at "mid" is smaller than "target".  Therefore all
+        // blocks before "mid" are uninteresting.
+        *left = mid;
+      } else {
+        // Key at "mid" is >= "target".  Therefore all blocks at or
+        // after "mid" are uninteresting.
+        right = mid - 1;
+      }
+    }
+    return true;
+  }
+
+  // Sets *left to the last restart point with a key < target, or to 0 if
+  // there is none, using the SLR model or RadixSpline.  Every restart key
+  // is predicted within max_error of its position, so the answer lies in
+  // [prediction - max_error - 1, prediction + max_error] and is found by a
+  // binary search of that window.  Should the window miss, the search
+  // gallops outward from its edge.
+  // The window is clamped to [floor, ceiling], which must hold the answer.
+  // REQUIRES: floor is 0 or has a key < target, and every restart point
+  // after ceiling has a key >= target.
+  bool SearchModel(const Slice& target, uint32_t floor, uint32_t ceiling,
+                   uint32_t* left) {
+    const uint64_t find = projection_->ToOrdinal(target);
+    uint32_t error;
+    const uint32_t prediksi = model_->Predict(find, &error);
+    const uint32_t last = num_restarts_ - 1;
+    const uint32_t low = std::min(
+        std::max(prediksi > error ? prediksi - error - 1 : 0, floor), ceiling);
+    const uint32_t high = std::max(
+        std::min(last - prediksi > error ? prediksi + error : last, ceiling),
+        floor);
+
+    if (!SearchWindow(target, floor, ceiling, low, high, left)) {
+      return false;
+    }
+    stats_->prediction_error +=
+        *left > prediksi ? *left - prediksi : prediksi - *left;
+    return true;
+  }
+
+  // Sets *left to the last restart point in [floor, ceiling] with a key <
+  // target by a binary search of [low, high], galloping outward from the
+  // window's edge should the answer lie outside it.
+  bool SearchWindow(const Slice& target, uint32_t floor, uint32_t ceiling,
+                    uint32_t low, uint32_t high, uint32_t* left) {
+    *left = low;
+    if (!BinarySearch(target, left, high)) {
+      return false;
+    }
+    int cmp;
+    if (*left == low && low > floor) {
+      // Every probed key was >= target, so the window's first restart
+      // point has not been compared yet.
+      if (!CompareRestartKey(low, target, &cmp)) {
+        return false;
+      }
+      if (cmp >= 0) {
+        return GallopLeft(target, low, left);
+      }
+    }
+    if (*left == high && high < ceiling) {
+      if (!CompareRestartKey(high + 1, target, &cmp)) {
+        return false;
+      }
+      if (cmp < 0) {
+        return GallopRight(target, high + 1, left);
+      }
+    }
+    return true;
+  }
+
+  // Sets *left to the last restart point with a key < target, or to 0 if
+  // there is none, by interpolating between the ordinals of restart keys.
+  bool SearchInterpolation(const Slice& target, uint32_t* left) {
+    return InterpolationSearch(
+        num_restarts_, model_->first_ordinal(), model_->last_ordinal(),
+        projection_->ToOrdinal(target),
+        [&](uint32_t index, bool* less, uint64_t* ordinal) {
+          Slice key;
+          if (!RestartKey(index, &key)) {
+            return false;
+          }
+          *less = Compare(key, target) < 0;
+          *ordinal = projection_->ToOrdinal(key);
+          return true;
+        },
+        left);
+  }
+
+  // Exponential search for *left below "bound", whose key is >= target.
+  bool GallopLeft(const Slice& target, uint32_t bound, uint32_t* left) {
+    stats_->fallbacks++;
+    uint32_t step = 1;
+    *left = 0;
+    while (bound > step) {
+      const uint32_t probe = bound - step;
+      int cmp;
+      if (!CompareRestartKey(probe, target, &cmp)) {
+        return false;
+      }
+      if (cmp < 0) {
+        *left = probe;
+        break;
+      }
+      bound = probe;
+      step *= 2;
+    }
+    return BinarySearch(target, left, bound - 1);
+  }
+
+  // Exponential search for *left from "start", whose key is < target.
+  bool GallopRight(const Slice& target, uint32_t start, uint32_t* left) {
+    stats_->fallbacks++;
+    const uint32_t last = num_restarts_ - 1;
+    uint32_t step = 1;
+    *left = start;
+    while (last - *left > step) {
+      const uint32_t probe = *left + step;
+      int cmp;
+      if (!CompareRestartKey(probe, target, &cmp)) {
+        return false;
+      }
+      if (cmp >= 0) {
+        return BinarySearch(target, left, probe - 1);
+      }
+      *left = probe;
+      step *= 2;
+    }
+    return BinarySearch(target, left, last);
+  }
+
   void CorruptionError() {
     current_ = restarts_;
     restart_index_ = num_restarts_;
-	// cout << "restart_index_3 :" << restart_index_ << endl;
+    run_index_ = -1;
     status_ = Status::Corruption("bad entry in block");
     key_.clear();
     value_.clear();
   }
 
   bool ParseNextKey() {
+    run_index_ = -1;
     current_ = NextEntryOffset();
     const char* p = data_ + current_;
     const char* limit = data_ + restarts_;  // Restarts come right after data
@@ -726,7 +734,6 @@ class Block::Iter : public Iterator {
       // No more entries to return.  Mark as invalid.
       current_ = restarts_;
       restart_index_ = num_restarts_;
-	  // cout << "restart_index_4 :" << restart_index_ << endl;
       return false;
     }
 
@@ -743,66 +750,372 @@ class Block::Iter : public Iterator {
       while (restart_index_ + 1 < num_restarts_ &&
              GetRestartPoint(restart_index_ + 1) < current_) {
         ++restart_index_;
-		
-		// cout << "restart_index_5 :" << restart_index_ << endl;
       }
       return true;
     }
   }
 };
 
-// vector<int> LowestLists()
-// {
-    // vector<int> mult;
-    // mult.reserve(5);
-	// mult.push_back(Lowest(1));
-	// mult.push_back(Lowest(2));
-	// mult.push_back(Lowest(3));
-	// mult.push_back(Lowest(4));
-	// mult.push_back(Lowest(5));
-    // return mult;
-// }
-
-Iterator* Block::NewIterator(const Comparator* comparator) {
+// Iterator over a fixed-width block.  Entries are addressed by index, so
+// a search model predicts the entry holding a key rather than a restart
+// point, and Seek ends on the entry it finds without scanning.
+class Block::FixedWidthIter : public Iterator {
+ private:
+  const Comparator* const comparator_;
+  const char* const data_;         // underlying block contents
+  uint32_t const keys_offset_;     // Offset of the key array, end of values
+  uint32_t const offsets_offset_;  // Offset of the value offset array
+  uint32_t const num_entries_;
+  uint32_t const key_width_;
+
+  // Index of the current entry.  == num_entries_ if !Valid()
+  uint32_t current_;
+  const Model* const model_;  // Search model, or nullptr for binary search
+  const KeyProjection* const projection_;  // Set iff model_ is set
+  BlockSearchStats own_stats_;  // Counts when the caller passes no stats
+  BlockSearchStats* const stats_;  // The caller's stats or &own_stats_
+  Slice value_;
+  Status status_;
+
+  Slice KeyAt(uint32_t index) const {
+    return Slice(data_ + keys_offset_ + index * key_width_, key_width_);
+  }
+
+  // Returns true iff the key of entry "index" is < target.
+  bool Less(uint32_t index, const Slice& target) {
+    stats_->probes++;
+    stats_->comparisons++;
+    return comparator_->Compare(KeyAt(index), target) < 0;
+  }
+
+  // Returns the first entry in [left, right) with a key >= target, or
+  // right if there is none.
+  uint32_t LowerBound(const Slice& target, uint32_t left, uint32_t right) {
+    while (left < right) {
+      const uint32_t mid = left + (right - left) / 2;
+      if (Less(mid, target)) {
+        left = mid + 1;
+      } else {
+        right = mid;
+      }
+    }
+    return left;
+  }
+
+  // Returns the first entry with a key >= target, searching only the
+  // window around the model's prediction unless the key lies outside it.
+  uint32_t SearchModel(const Slice& target) {
+    uint32_t error;
+    const uint32_t predicted =
+        model_->Predict(projection_->ToOrdinal(target), &error);
+    const uint32_t low = predicted > error ? predicted - error : 0;
+    const uint32_t high = static_cast<uint32_t>(
+        std::min<uint64_t>(num_entries_, uint64_t{predicted} + error + 1));
+    uint32_t found = LowerBound(target, low, high);
+    if (found == low && low > 0 && !Less(low - 1, target)) {
+      stats_->fallbacks++;
+      found = LowerBound(target, 0, low - 1);
+    } else if (found == high && high < num_entries_ && Less(high, target)) {
+      stats_->fallbacks++;
+      found = LowerBound(target, high + 1, num_entries_);
+    }
+    stats_->prediction_error +=
+        found > predicted ? found - predicted : predicted - found;
+    return found;
+  }
+
+  // Returns the first entry with a key >= target by interpolating between
+  // the ordinals of keys.
+  uint32_t SearchInterpolation(const Slice& target) {
+    uint32_t last_less;
+    InterpolationSearch(
+        num_entries_, model_->first_ordinal(), model_->last_ordinal(),
+        projection_->ToOrdinal(target),
+        [&](uint32_t index, bool* less, uint64_t* ordinal) {
+          *less = Less(index, target);
+          *ordinal = projection_->ToOrdinal(KeyAt(index));
+          return true;
+        },
+        &last_less);
+    // The search never probes the first entry
+    return (last_less > 0 || Less(0, target)) ? last_less + 1 : 0;
+  }
+
+  // Points value_ at the value of the current entry.
+  void ParseValue() {
+    if (current_ >= num_entries_) {
+      current_ = num_entries_;
+      value_.clear();
+      return;
+    }
+    const char* offsets = data_ + offsets_offset_;
+    const uint32_t start = DecodeFixed32(offsets + current_ * sizeof(uint32_t));
+    const uint32_t limit =
+        current_ + 1 < num_entries_
+            ? DecodeFixed32(offsets + (current_ + 1) * sizeof(uint32_t))
+            : keys_offset_;
+    if (start > limit || limit > keys_offset_) {
+      current_ = num_entries_;
+      status_ = Status::Corruption("bad entry in block");
+      value_.clear();
+      return;
+    }
+    value_ = Slice(data_ + start, limit - start);
+  }
+
+ public:
+  FixedWidthIter(const Comparator* comparator, const char* data,
+                 uint32_t offsets_offset, uint32_t num_entries,
+                 uint32_t key_width, const Model* model,
+                 const KeyProjection* projection, BlockSearchStats* stats)
+      : comparator_(comparator),
+        data_(data),
+        keys_offset_(offsets_offset - num_entries * key_width),
+        offsets_offset_(offsets_offset),
+        num_entries_(num_entries),
+        key_width_(key_width),
+        current_(num_entries),
+        model_(model),
+        projection_(projection),
+        stats_(stats != nullptr ? stats : &own_stats_) {
+    assert(num_entries_ > 0);
+  }
+
+  ~FixedWidthIter() override {
+    if (stats_ == &own_stats_) {
+      RecordBlockSearchStats(own_stats_);
+    }
+  }
+
+  bool Valid() const override { return current_ < num_entries_; }
+  Status status() const override { return status_; }
+  Slice key() const override {
+    assert(Valid());
+    return KeyAt(current_);
+  }
+  Slice value() const override {
+    assert(Valid());
+    return value_;
+  }
+
+  void Next() override {
+    assert(Valid());
+    current_++;
+    ParseValue();
+  }
+
+  void Prev() override {
+    assert(Valid());
+    current_ = current_ == 0 ? num_entries_ : current_ - 1;
+    ParseValue();
+  }
+
+  void Seek(const Slice& target) override {
+    if (stats_ == &own_stats_) MaybeFlushSearchStats(&own_stats_);
+    stats_->seeks++;
+    if (model_ != nullptr && model_->predicts()) {
+      stats_->model_seeks++;
+      current_ = SearchModel(target);
+    } else if (model_ != nullptr) {
+      stats_->interpolation_seeks++;
+      current_ = SearchInterpolation(target);
+    } else {
+      stats_->binary_seeks++;
+      current_ = LowerBound(target, 0, num_entries_);
+    }
+    ParseValue();
+  }
+
+  void SeekToFirst() override {
+    current_ = 0;
+    ParseValue();
+  }
+
+  void SeekToLast() override {
+    current_ = num_entries_ - 1;
+    ParseValue();
+  }
+};
+
+namespace {
+
+// The fields of BlockSearchStats, in the order of the counters below.
+uint64_t BlockSearchStats::*const kSearchStatsFields[] = {
+    &BlockSearchStats::seeks,
+    &BlockSearchStats::probes,
+    &BlockSearchStats::fallbacks,
+    &BlockSearchStats::skipped,
+    &BlockSearchStats::rescans,
+    &BlockSearchStats::binary_seeks,
+    &BlockSearchStats::model_seeks,
+    &BlockSearchStats::interpolation_seeks,
+    &BlockSearchStats::comparisons,
+    &BlockSearchStats::prediction_error,
+};
+constexpr int kNumSearchStatsFields =
+    sizeof(kSearchStatsFields) / sizeof(kSearchStatsFields[0]);
+
+class ThreadSearchStats;
+
+// Every live thread's counters, and the sums of those of exited threads.
+struct SearchStatsRegistry {
+  port::Mutex mu;
+  ThreadSearchStats* threads GUARDED_BY(mu) = nullptr;
+  BlockSearchStats exited GUARDED_BY(mu);
+};
+
+SearchStatsRegistry* Registry() {
+  static NoDestructor<SearchStatsRegistry> registry;
+  return registry.get();
+}
+
+// One thread's counters.  Only the owning thread writes them, so adding
+// to them takes no atomic read-modify-write; the atomics only let
+// GetBlockSearchStats() read them from other threads.
+class ThreadSearchStats {
+ public:
+  ThreadSearchStats() : prev_(nullptr) {
+    for (std::atomic<uint64_t>& counter : counters_) {
+      counter.store(0, std::memory_order_relaxed);
+    }
+    SearchStatsRegistry* registry = Registry();
+    MutexLock l(&registry->mu);
+    next_ = registry->threads;
+    if (next_ != nullptr) next_->prev_ = this;
+    registry->threads = this;
+  }
+
+  ~ThreadSearchStats() {
+    SearchStatsRegistry* registry = Registry();
+    MutexLock l(&registry->mu);
+    AddTo(&registry->exited);
+    if (prev_ != nullptr) {
+      prev_->next_ = next_;
+    } else {
+      registry->threads = next_;
+    }
+    if (next_ != nullptr) next_->prev_ = prev_;
+  }
+
+  ThreadSearchStats(const ThreadSearchStats&) = delete;
+  ThreadSearchStats& operator=(const ThreadSearchStats&) = delete;
+
+  void Add(const BlockSearchStats& stats) {
+    for (int i = 0; i < kNumSearchStatsFields; i++) {
+      const uint64_t delta = stats.*kSearchStatsFields[i];
+      if (delta != 0) {
+        counters_[i].store(
+            counters_[i].load(std::memory_order_relaxed) + delta,
+            std::memory_order_relaxed);
+      }
+    }
+  }
+
+  void AddTo(BlockSearchStats* stats) const {
+    for (int i = 0; i < kNumSearchStatsFields; i++) {
+      stats->*kSearchStatsFields[i] +=
+          counters_[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  ThreadSearchStats* next() const { return next_; }
+
+ private:
+  std::atomic<uint64_t> counters_[kNumSearchStatsFields];
+  ThreadSearchStats* prev_;  // Neighbours in the registry, guarded by its mu
+  ThreadSearchStats* next_;
+};
+
+}  // namespace
+
+void RecordBlockSearchStats(const BlockSearchStats& stats) {
+  static thread_local ThreadSearchStats thread_stats;
+  thread_stats.Add(stats);
+}
+
+void GetBlockSearchStats(BlockSearchStats* stats) {
+  *stats = BlockSearchStats();
+  SearchStatsRegistry* registry = Registry();
+  MutexLock l(&registry->mu);
+  for (const ThreadSearchStats* t = registry->threads; t != nullptr;
+       t = t->next()) {
+    t->AddTo(stats);
+  }
+  for (uint64_t BlockSearchStats::*field : kSearchStatsFields) {
+    stats->*field += registry->exited.*field;
+  }
+}
+
+size_t Block::ApproximateMemoryUsage() const {
+  return size_ + (model_ != nullptr ? model_->ApproximateMemoryUsage() : 0);
+}
+
+Iterator* Block::NewIterator(const Comparator* comparator,
+                             const KeyProjection* projection,
+                             BlockSearchStats* stats) {
   if (size_ < sizeof(uint32_t)) {
     return NewErrorIterator(Status::Corruption("bad block contents"));
   }
   const uint32_t num_restarts = NumRestarts();
-  
-   // //init LR dividend
-  // const uint32_t dividend = Dividend(1);
-  // const uint32_t divisor = Divisor(1);
-  // //init LR lowest subset
-  // const float lowest = Lowest(1);
-  // // vector<int> lowestLists = LowestLists();
-  
-  // cout << "NumRestarts(): " << num_restarts << endl;
-  // cout << "Dividend(): " << dividend << endl;
-  // cout << "Divisor(): " << divisor << endl; 
-  // cout << "Lowest(): " << lowest << endl;
-  
-  // vector<int> LowestLists;
-    // LowestLists.reserve(5);
-	// LowestLists.push_back(Lowest(1));
-	// LowestLists.push_back(Lowest(2));
-	// LowestLists.push_back(Lowest(3));
-	// LowestLists.push_back(Lowest(4));
-	// LowestLists.push_back(Lowest(5));
-    
-	// cout << "SLR" << SLR << endl;
-  
-  // printf( "%6.4lf \n", lowest );
-  
-  // printf("dividend %02hhx \n", dividend);
   if (num_restarts == 0) {
     return NewEmptyIterator();
   } else {
-    // return new Iter(comparator, data_, restart_offset_, num_restarts);
-    
-	//add some variable into the iteration
-    return new Iter(comparator, data_, restart_offset_, num_restarts,size_, SLR, debug);
-   
+    const Model* model = (projection != nullptr) ? model_ : nullptr;
+    if (key_width_ != 0) {
+      return new FixedWidthIter(comparator, data_, restart_offset_,
+                                num_restarts, key_width_, model, projection,
+                                stats);
+    }
+    return new Iter(comparator, data_, restart_offset_, num_restarts, model,
+                    projection, stats);
+  }
+}
+
+bool Block::AttachModel(BlockModelType type, const Slice& input) {
+  if (size_ < sizeof(uint32_t) ||
+      (type != kSLRModel && type != kRadixSplineModel)) {
+    return false;
+  }
+  const Model* model = Model::Decode(type, input, NumRestarts());
+  if (model == nullptr) {
+    return false;
+  }
+  delete model_;
+  model_ = model;
+  return true;
+}
+
+bool Block::MeasureModelError(const KeyProjection* projection,
+                              BlockModelError* error) const {
+  if (model_ == nullptr || !model_->predicts()) {
+    return false;
+  }
+  const uint32_t num_restarts = NumRestarts();
+  const char* limit = data_ + restart_offset_;
+  for (uint32_t i = 0; i < num_restarts; i++) {
+    Slice key;
+    if (key_width_ != 0) {
+      // Entry i of a fixed-width block
+      key = Slice(limit - (num_restarts - i) * key_width_, key_width_);
+    } else {
+      const uint32_t offset = DecodeFixed32(limit + i * sizeof(uint32_t));
+      uint32_t shared, non_shared, value_length;
+      const char* key_ptr = DecodeEntry(data_ + offset, limit, &shared,
+                                        &non_shared, &value_length);
+      if (key_ptr == nullptr || shared != 0) {
+        return false;
+      }
+      key = Slice(key_ptr, non_shared);
+    }
+    uint32_t max_error;
+    const uint32_t predicted =
+        model_->Predict(projection->ToOrdinal(key), &max_error);
+    const uint32_t distance = predicted > i ? predicted - i : i - predicted;
+    error->restarts++;
+    error->total += distance;
+    error->max = std::max(error->max, distance);
   }
+  return true;
 }
 
 }  // namespace leveldb
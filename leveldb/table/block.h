@@ -13,13 +13,45 @@
 namespace leveldb {
 
 struct BlockContents;
+enum BlockModelType : uint8_t;
 class Comparator;
+class KeyProjection;
+
+// Cost of the restart point searches done by block iterators, for
+// comparing search modes.
+struct BlockSearchStats {
+  uint64_t seeks = 0;      // Calls to Seek()
+  uint64_t probes = 0;     // Restart keys compared with a seek target
+  uint64_t fallbacks = 0;  // Model searches that left the predicted window
+  uint64_t skipped = 0;    // Entries of a restart run passed without a compare
+  uint64_t rescans = 0;    // Restart runs walked again after skipping too far
+  uint64_t binary_seeks = 0;         // Seeks by binary search
+  uint64_t model_seeks = 0;          // Seeks by SLR model or RadixSpline
+  uint64_t interpolation_seeks = 0;  // Seeks by interpolation search
+  uint64_t comparisons = 0;          // Keys compared with a seek target
+  uint64_t prediction_error = 0;     // Sum over model seeks of the distance
+                                     // from the prediction to the answer
+};
+
+// Adds "stats" to the calling thread's counters.  Block iterators made
+// without caller stats add their own to these every few dozen seeks and
+// when they are destroyed.
+void RecordBlockSearchStats(const BlockSearchStats& stats);
+
+// Stores in *stats the sums of the counters of every thread, including
+// threads that have exited, since the process started.
+void GetBlockSearchStats(BlockSearchStats* stats);
+
+// Accuracy of block search models over their own restart keys.
+struct BlockModelError {
+  uint64_t restarts = 0;  // Restart keys measured
+  uint64_t total = 0;     // Sum of the prediction errors, in restart points
+  uint32_t max = 0;       // Largest prediction error
+};
 
 class Block {
  public:
   // Initialize the block with the specified contents.
-  
-  
   explicit Block(const BlockContents& contents);
 
   Block(const Block&) = delete;
@@ -28,31 +60,49 @@ class Block {
   ~Block();
 
   size_t size() const { return size_; }
-  Iterator* NewIterator(const Comparator* comparator);
+
+  // Returns the bytes of memory the block takes: its contents and its
+  // decoded search model, if any.
+  size_t ApproximateMemoryUsage() const;
+
+  // Return an iterator over the block.  If the block carries a search
+  // model, "projection" maps seek targets to the ordinals the model was
+  // built over; without a projection the model is ignored.  If "stats" is
+  // non-null, the iterator adds the cost of its seeks to it, and otherwise
+  // to the thread's counters (see RecordBlockSearchStats()).
+  Iterator* NewIterator(const Comparator* comparator,
+                        const KeyProjection* projection = nullptr,
+                        BlockSearchStats* stats = nullptr);
+
+  // Replaces the block's search model with the model of type "type"
+  // encoded in "input", which need not outlive the call.  Used for models
+  // stored apart from the block, such as a table's learned index.  Only
+  // kSLRModel and kRadixSplineModel models can be attached.  Returns
+  // false, and leaves the block unchanged, if "input" is not a valid
+  // model for it.
+  bool AttachModel(BlockModelType type, const Slice& input);
+
+  // Adds to *error how far the search model's prediction for each restart
+  // key, projected by "projection", falls from that key's restart point.
+  // Returns false if the block has no SLR model or RadixSpline, or is
+  // corrupt.
+  bool MeasureModelError(const KeyProjection* projection,
+                         BlockModelError* error) const;
 
  private:
+  class FixedWidthIter;
   class Iter;
+  class Model;
 
   uint32_t NumRestarts() const;
-  
-  //define constant of LR dividend
-  uint32_t MetaPosition(int type,int pos) const;
-  uint32_t Dividend(int pos) const;
-  uint32_t Divisor(int pos) const;
-  uint32_t Lowest(int pos) const;
-  
-  // vector<int> LowestLists();
 
   const char* data_;
   size_t size_;
-  uint32_t restart_offset_;  // Offset in data_ of restart array
+  uint32_t restart_offset_;  // Offset in data_ of restart array (of value
+                             // offsets in a fixed-width block)
+  uint32_t key_width_;       // Key width of a fixed-width block, else 0
+  const Model* model_;       // Decoded search model, nullptr if none
   bool owned_;               // Block owns data_[]
-  
-  
-  int new_meta_size = 32;  // total of meta in block builder (included num_restarts)
-  bool SLR = false;	 	   // set to false to use default binary search           
-  bool debug = false;      // set to true to show the debug information
-    
 };
 
 }  // namespace leveldb
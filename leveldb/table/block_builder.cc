@@ -23,26 +23,168 @@
 //
 // The trailer of the block has the form:
 //     restarts: uint32[num_restarts]
-//     num_restarts: uint32
+//     model: char[model_size]         (only if kBlockModelFlag is set)
+//     model_size: uint32              (only if kBlockModelFlag is set)
+//     model_type: uint8               (only if kBlockModelFlag is set)
+//     num_restarts: uint32            (kBlockModelFlag in the top bit)
 // restarts[i] contains the offset within the block of the ith restart point.
+// The optional model is written for Options::block_search_mode ==
+// kSLRSearch and lets readers predict the restart point holding a key to
+// within Options::block_search_epsilon restart points (see format.h).
+// Under kAdaptiveSearch each block instead records whichever of the SLR
+// model, interpolation search and plain binary search costs the fewest
+// restart key comparisons for it.  kRadixSplineSearch stores a RadixSpline
+// over the restart keys instead of the SLR model.
+//
+// With Options::fixed_width_blocks and a comparator that declares a fixed
+// key width, keys are instead stored whole in a dense array after the
+// values (see format.h).  Every entry then plays the part of a restart
+// point: search models are fitted over the ordinals of all keys.
 
 #include "table/block_builder.h"
 
 #include <algorithm>
 #include <cassert>
+#include <utility>
 
 #include "leveldb/comparator.h"
+#include "leveldb/key_projection.h"
 #include "leveldb/options.h"
+#include "table/format.h"
+#include "table/interpolation_search.h"
 #include "util/coding.h"
 
-#include<iostream>
-using namespace std;
-
 namespace leveldb {
 
+namespace {
+
+// Blocks with at most this many restart points are searched quickly
+// enough without a model ...
+constexpr size_t kMinModelRestarts = 52;
+
+// ... unless their restart runs hold at least this many entries, which a
+// model also spares most compares (see Block::Iter::PredictRunOffset).
+constexpr int kLongRunLength = 32;
+
+// The functions below count the restart keys each search of
+// Block::Iter::Seek compares to find a target with ordinal "find" that is
+// above exactly "below" of the block's restart keys, whose ordinals are
+// "ordinals".
+
+uint64_t BinarySearchCost(uint32_t left, uint32_t right, uint32_t below) {
+  uint64_t probes = 0;
+  while (left < right) {
+    const uint32_t mid = (left + right + 1) / 2;
+    probes++;
+    if (mid < below) {
+      left = mid;
+    } else {
+      right = mid - 1;
+    }
+  }
+  return probes;
+}
+
+uint64_t SLRSearchCost(const std::vector<uint64_t>& ordinals,
+                       const PiecewiseLinearModel& model, uint64_t find,
+                       uint32_t below) {
+  const uint32_t last = ordinals.size() - 1;
+  uint32_t error;
+  const uint32_t prediction = std::min(model.Predict(find, &error), last);
+  const uint32_t low = prediction > error ? prediction - error - 1 : 0;
+  const uint32_t high = last - prediction > error ? prediction + error : last;
+  const uint32_t answer = below > 0 ? below - 1 : 0;
+  if (answer < low || answer > high) {
+    // The search gallops out of the window, which can take twice the
+    // comparisons of a binary search over the whole block.
+    return 2 * BinarySearchCost(0, last, below) + 2;
+  }
+  // A search ending on an edge of the window checks the key beyond it.
+  return BinarySearchCost(low, high, below) + (answer == low && low > 0) +
+         (answer == high && high < last);
+}
+
+uint64_t InterpolationSearchCost(const std::vector<uint64_t>& ordinals,
+                                 uint64_t find, uint32_t below) {
+  uint64_t probes = 0;
+  uint32_t left;
+  InterpolationSearch(
+      ordinals.size(), ordinals.front(), ordinals.back(), find,
+      [&](uint32_t index, bool* less, uint64_t* ordinal) {
+        probes++;
+        *less = index < below;
+        *ordinal = ordinals[index];
+        return true;
+      },
+      &left);
+  return probes;
+}
+
+// Stores in *type the model that finds the restart keys with "ordinals",
+// and keys halfway between them, in the fewest comparisons, given their
+// SLR "segments".  Returns false if a plain binary search does at least
+// as well, unless the block has "long_runs": those are walked faster with
+// either model, so the block keeps the better one.  Ties go to the smaller
+// trailer.
+bool ChooseModel(const std::vector<uint64_t>& ordinals,
+                 const std::vector<LinearSegment>& segments, bool long_runs,
+                 BlockModelType* type) {
+  const PiecewiseLinearModel model(segments);
+  const uint32_t n = ordinals.size();
+  uint64_t binary = 0, interpolation = 0, slr = 0;
+  for (uint32_t i = 0; i < 2 * n - 1; i++) {
+    // Even i are restart keys; odd i fall between two of them.
+    const uint32_t below = (i + 1) / 2;
+    uint64_t find = ordinals[i / 2];
+    if (i % 2 == 1) {
+      find += (ordinals[below] - find) / 2;
+    }
+    binary += BinarySearchCost(0, n - 1, below);
+    interpolation += InterpolationSearchCost(ordinals, find, below);
+    slr += SLRSearchCost(ordinals, model, find, below);
+  }
+  if (slr < interpolation && (slr < binary || long_runs)) {
+    *type = kSLRModel;
+  } else if (interpolation < binary || long_runs) {
+    *type = kInterpolationModel;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Adds to *stats a block with a model of "segments" segments (or knots),
+// and how far "model" predicts each of "ordinals" from its position.
+template <typename Model>
+void AddModelErrors(const Model& model, size_t segments,
+                    const std::vector<uint64_t>& ordinals,
+                    TableModelStats* stats) {
+  stats->modeled_blocks++;
+  stats->segments += segments;
+  for (uint32_t i = 0; i < ordinals.size(); i++) {
+    uint32_t max_error;
+    const uint32_t predicted = model.Predict(ordinals[i], &max_error);
+    stats->AddError(predicted > i ? predicted - i : i - predicted);
+  }
+}
+
+}  // namespace
+
 BlockBuilder::BlockBuilder(const Options* options)
-    : options_(options), restarts_(), counter_(0), finished_(false) {
+    : options_(options),
+      restarts_(),
+      fitter_(options->block_search_epsilon),
+      closed_segments_(0),
+      model_bytes_(0),
+      spline_(options->block_search_epsilon),
+      spline_knots_(0),
+      spline_bytes_(0),
+      key_width_(0),
+      prefix_only_(false),
+      counter_(0),
+      finished_(false) {
   assert(options->block_restart_interval >= 1);
+  assert(options->block_search_epsilon >= 0);
   restarts_.push_back(0);  // First restart point is at offset 0
 }
 
@@ -50,157 +192,237 @@ void BlockBuilder::Reset() {
   buffer_.clear();
   restarts_.clear();
   restarts_.push_back(0);  // First restart point is at offset 0
+  fitter_ = PiecewiseLinearFitter(options_->block_search_epsilon);
+  closed_segments_ = 0;
+  model_bytes_ = 0;
+  spline_ = RadixSplineBuilder(options_->block_search_epsilon);
+  spline_knots_ = 0;
+  spline_bytes_ = 0;
+  key_width_ = 0;
+  prefix_only_ = false;
+  keys_.clear();
+  value_offsets_.clear();
   counter_ = 0;
   finished_ = false;
   last_key_.clear();
 }
 
+size_t BlockBuilder::KeyWidth(const Options* options) {
+  return options->fixed_width_blocks ? options->comparator->FixedKeyWidth()
+                                     : 0;
+}
+
+void BlockBuilder::LeaveFixedWidth() {
+  const std::string keys = keys_;
+  const std::string values = buffer_;
+  const std::vector<uint32_t> offsets = value_offsets_;
+  const size_t width = key_width_;
+  Reset();
+  prefix_only_ = true;
+  for (size_t i = 0; i < offsets.size(); i++) {
+    const uint32_t limit =
+        i + 1 < offsets.size() ? offsets[i + 1] : values.size();
+    Add(Slice(keys.data() + i * width, width),
+        Slice(values.data() + offsets[i], limit - offsets[i]));
+  }
+}
+
+size_t BlockBuilder::NumSlots() const {
+  return key_width_ != 0 ? value_offsets_.size() : restarts_.size();
+}
+
+bool BlockBuilder::CollectOrdinals() const {
+  return options_->block_search_mode != kBinarySearch &&
+         options_->key_projection != nullptr;
+}
+
+bool BlockBuilder::LongRuns() const {
+  return key_width_ == 0 && options_->block_restart_interval >= kLongRunLength;
+}
+
+bool BlockBuilder::UseModel() const {
+  // Small blocks are searched quickly enough without a model.  The
+  // ordinals are incomplete if the options changed during this block.
+  return CollectOrdinals() &&
+         NumSlots() > (LongRuns() ? 1 : kMinModelRestarts) &&
+         fitter_.num_keys() == NumSlots() &&
+         (options_->block_search_mode != kRadixSplineSearch ||
+          spline_.num_keys() == NumSlots());
+}
+
+size_t BlockBuilder::ModelSize() const {
+  return options_->block_search_mode == kRadixSplineSearch
+             ? RadixSplineModelSize()
+             : SLRModelSize();
+}
+
+size_t BlockBuilder::SLRModelSize() const {
+  // The open segment's max_error is only bounded by epsilon, which has
+  // the same varint length as the measured error for any sane epsilon.
+  const std::vector<LinearSegment>& closed = fitter_.closed_segments();
+  const uint64_t base =
+      closed.empty() ? 0 : closed.back().first_key + closed.back().key_span;
+  return VarintLength(fitter_.NumSegments()) + model_bytes_ +
+         SLRSegmentLength(fitter_.OpenSegment(), base) +
+         kBlockModelTrailerSize;
+}
+
+size_t BlockBuilder::RadixSplineModelSize() const {
+  const std::vector<SplinePoint>& knots = spline_.knots();
+  const SplinePoint& last = spline_.last_point();
+  const bool last_is_knot = last.key == knots.back().key;
+  return 1 + VarintLength(options_->block_search_epsilon) +
+         VarintLength(knots.size() + (last_is_knot ? 0 : 1)) + spline_bytes_ +
+         (last_is_knot ? 0 : SplinePointLength(last, knots.back())) +
+         kBlockModelTrailerSize;
+}
+
 size_t BlockBuilder::CurrentSizeEstimate() const {
-  // return (buffer_.size() +                       // Raw data buffer
-          // restarts_.size() * sizeof(uint32_t) +  // Restart array
-          // sizeof(uint32_t));                     // Restart array length
-		  
-	return (buffer_.size() +                       // Raw data buffer
-          restarts_.size() * (sizeof(uint32_t) * new_meta_size )+  // Restart array
-          sizeof(uint32_t));   
-}
-
-static inline const char* DecodeEntry(const char* p, const char* limit,
-                                      uint32_t* shared, uint32_t* non_shared,
-                                      uint32_t* value_length) {
-  if (limit - p < 3) return nullptr;
-  *shared = reinterpret_cast<const uint8_t*>(p)[0];
-  *non_shared = reinterpret_cast<const uint8_t*>(p)[1];
-  *value_length = reinterpret_cast<const uint8_t*>(p)[2];
-  if ((*shared | *non_shared | *value_length) < 128) {
-    // Fast path: all three values are encoded in one byte each
-    p += 3;
+  if (key_width_ != 0) {
+    return (buffer_.size() +                           // Values
+            keys_.size() +                             // Keys
+            value_offsets_.size() * sizeof(uint32_t) + // Value offsets
+            sizeof(uint32_t) +                         // Key width
+            (UseModel() ? ModelSize() : 0) +           // Search model
+            sizeof(uint32_t));                         // Entry count
+  }
+  return (buffer_.size() +                        // Raw data buffer
+          restarts_.size() * sizeof(uint32_t) +   // Restart array
+          (UseModel() ? ModelSize() : 0) +        // Search model
+          sizeof(uint32_t));                      // Restart array length
+}
+
+Slice BlockBuilder::Finish(TableModelStats* stats) {
+  uint32_t count;
+  if (key_width_ != 0) {
+    // Append the key array, the value offsets and the key width
+    buffer_.append(keys_);
+    for (size_t i = 0; i < value_offsets_.size(); i++) {
+      PutFixed32(&buffer_, value_offsets_[i]);
+    }
+    PutFixed32(&buffer_, key_width_);
+    count = value_offsets_.size() | kBlockFixedWidthFlag;
   } else {
-    if ((p = GetVarint32Ptr(p, limit, shared)) == nullptr) return nullptr;
-    if ((p = GetVarint32Ptr(p, limit, non_shared)) == nullptr) return nullptr;
-    if ((p = GetVarint32Ptr(p, limit, value_length)) == nullptr) return nullptr;
-  }
-
-  if (static_cast<uint32_t>(limit - p) < (*non_shared + *value_length)) {
-    return nullptr;
-  }
-  return p;
-}
-
-static inline const uint32_t GetKey(const char* data_,uint32_t res, int pos){
-	const char *cursor_low = data_ + res + pos * sizeof(uint32_t);  
-	uint32_t region_offset_low = leveldb::DecodeFixed32(cursor_low);
-	uint32_t shared_low, non_shared_low, value_length_low;
-	const char* key_ptr_low = DecodeEntry(data_ + region_offset_low,data_ + res, &shared_low, &non_shared_low, &value_length_low);
-
-	uint32_t skey_i_low;
-	if (key_ptr_low == nullptr || (shared_low != 0)) {
-	// cout << "key_ptr KOSONG " << endl;
-	}else{
-		Slice mid_key_low(key_ptr_low, non_shared_low);
-		// cout << "key_ptr_low ada " << endl;
-		std::string skey_low= mid_key_low.ToString();
-		skey_i_low = stoi(skey_low);
-	}
-	
-	return skey_i_low;
-}
-
-Slice BlockBuilder::Finish() {
-  // Append restart array
-  for (size_t i = 0; i < restarts_.size(); i++) {
-	PutFixed32(&buffer_, restarts_[i]);
-  }
-  
-  //SLR Segmentation
-  int segment_size;
-  int low = 0;
-  
-  int high = restarts_.size() -2 ;
-  
-  uint32_t skey_i_low,skey_i_high,diff,rest;
-  int segment_len = 10;
-  
-  // if SLR is true
-  // and if the keys is quite big
-  // save the segments
-  if(high > 50 && SLR ){   
-	  //this is restart_offset or restarts_ from block.cc
-	  uint32_t helper = buffer_.size() + (sizeof(uint32_t) * new_meta_size);
-	  uint32_t res = helper - (new_meta_size + restarts_.size()) * sizeof(uint32_t);
-	  
-	  // buffer_.data() is data_ in block.cc
-	  const char* data_ = buffer_.data();
-	  
-	  
-	  //Create Segments
-	  segment_size = (high-low)/segment_len;
-	  
-	  int segment_no=1;
-	  int s= low;
-	  for(int seg=1; seg <= segment_len; seg ++){
-		  
-		  int hi= s + segment_size;
-		  int first_key= GetKey(data_, res, s);
-		  
-		  if(hi > high){
-			  hi=high;
-		  }
-		  int last_key= GetKey(data_, res, hi);
-		 
-		  int dividend=last_key - first_key;
-		  int divisor = hi-s;
-		  
-		  // float coefs = (float)(last_key - first_key)/(divisor);
-		  
-		  //save into tails encoded
-			PutFixed32(&buffer_, dividend);
-			PutFixed32(&buffer_, divisor);
-			PutFixed32(&buffer_, first_key);
-		
-			// if(debug){
-			  // printf("segment %d low %d\n",seg,s);
-			  // printf("segment %d hi %d\n",seg,hi);
-			  // printf("segment %d high %d\n",seg,high);
-			  // printf("segment %d first_key %d\n",seg,first_key);
-			  // printf("segment %d last_key %d\n",seg,last_key);
-			  // printf("segment %d coef %.5f\n",seg,coefs);
-			  // printf("segment %d size %d\n",seg,divisor + 1);
-			  // printf("segment %d dividend %d\n",seg,dividend);
-			  // printf("segment %d divisor %d\n\n",seg,divisor);
-			  // printf("\n");
-			  // printf("\n");
-			// }
-		  
-		  s = hi+1;
-	  }
-		  
-  }else{
-	  //set it as zero if SLR isn't active
-	  for(int seg=1; seg <= segment_len; seg ++){
-		  PutFixed32(&buffer_, 0);
-		  PutFixed32(&buffer_, 0);
-		  PutFixed32(&buffer_, 0);
-	  }
-  } 
-  
-  
-  //End Segmentation
-  
-  //save segment_size as meta
-  PutFixed32(&buffer_, segment_size+1);
-  PutFixed32(&buffer_, restarts_.size());
- 
+    // Append restart array
+    for (size_t i = 0; i < restarts_.size(); i++) {
+      PutFixed32(&buffer_, restarts_[i]);
+    }
+    count = restarts_.size();
+  }
+  if (stats != nullptr) {
+    stats->blocks++;
+  }
+  if (AppendModel(stats)) {
+    count |= kBlockModelFlag;
+  }
+  PutFixed32(&buffer_, count);
+
   finished_ = true;
   return Slice(buffer_);
 }
 
+bool BlockBuilder::AppendModel(TableModelStats* stats) {
+  if (!UseModel()) {
+    return false;
+  }
+  BlockModelType type = kSLRModel;
+  const size_t model_start = buffer_.size();
+  if (options_->block_search_mode == kRadixSplineSearch) {
+    // The spline bends wherever the line from its last knot would leave
+    // the epsilon corridor around a restart key.
+    std::vector<SplinePoint> knots;
+    spline_.Finish(&knots);
+    type = kRadixSplineModel;
+    const int radix_bits = RadixBitsFor(knots.size());
+    const uint32_t max_error = SplineError(knots, fitter_.keys());
+    EncodeRadixSplineModel(knots, radix_bits, max_error, &buffer_);
+    if (stats != nullptr) {
+      const size_t count = knots.size();
+      const RadixSplineModel model(std::move(knots), radix_bits, max_error);
+      AddModelErrors(model, count, fitter_.keys(), stats);
+    }
+  } else {
+    // Segmented linear regression: the fitter cuts the restart points
+    // into as many segments as it takes to predict every restart key
+    // within epsilon restart points of its position.
+    std::vector<LinearSegment> segments;
+    fitter_.Finish(&segments);
+    if (options_->block_search_mode == kAdaptiveSearch &&
+        !ChooseModel(fitter_.keys(), segments, LongRuns(), &type)) {
+      return false;
+    }
+    if (type == kSLRModel) {
+      EncodeSLRModel(segments, &buffer_);
+      if (stats != nullptr) {
+        const size_t count = segments.size();
+        const PiecewiseLinearModel model(std::move(segments));
+        AddModelErrors(model, count, fitter_.keys(), stats);
+      }
+    } else {
+      EncodeInterpolationModel(segments.front().first_key,
+                               fitter_.last_key(), &buffer_);
+    }
+  }
+  PutFixed32(&buffer_, buffer_.size() - model_start);
+  buffer_.push_back(static_cast<char>(type));
+  return true;
+}
+
+void BlockBuilder::AddOrdinal(const Slice& key, size_t slot) {
+  if (!CollectOrdinals()) {
+    return;
+  }
+  const uint64_t ordinal = options_->key_projection->ToOrdinal(key);
+  // A projection that is not monotone over this block leaves the
+  // ordinals incomplete, so no model is built for it.
+  if (fitter_.num_keys() != slot ||
+      (fitter_.num_keys() > 0 && ordinal < fitter_.last_key())) {
+    return;
+  }
+  fitter_.Add(ordinal);
+  const std::vector<LinearSegment>& closed = fitter_.closed_segments();
+  for (; closed_segments_ < closed.size(); closed_segments_++) {
+    uint64_t base = 0;
+    if (closed_segments_ > 0) {
+      const LinearSegment& prev = closed[closed_segments_ - 1];
+      base = prev.first_key + prev.key_span;
+    }
+    model_bytes_ += SLRSegmentLength(closed[closed_segments_], base);
+  }
+  if (options_->block_search_mode == kRadixSplineSearch &&
+      spline_.num_keys() == slot) {
+    spline_.Add(ordinal);
+    const std::vector<SplinePoint>& knots = spline_.knots();
+    for (; spline_knots_ < knots.size(); spline_knots_++) {
+      const SplinePoint prev =
+          spline_knots_ > 0 ? knots[spline_knots_ - 1] : SplinePoint{0, 0};
+      spline_bytes_ += SplinePointLength(knots[spline_knots_], prev);
+    }
+  }
+}
+
 void BlockBuilder::Add(const Slice& key, const Slice& value) {
-  Slice last_key_piece(last_key_);
   assert(!finished_);
   assert(counter_ <= options_->block_restart_interval);
-  assert(buffer_.empty()  // No values yet?
-         || options_->comparator->Compare(key, last_key_piece) > 0);
+  assert(empty()  // No values yet?
+         || options_->comparator->Compare(key, last_key_) > 0);
+  if (empty()) {
+    // Like the other options, the format is read when it is first needed
+    key_width_ = prefix_only_ ? 0 : KeyWidth(options_);
+  }
+  if (key_width_ != 0 && key.size() != key_width_) {
+    // The comparator's key width is a promise the keys did not keep
+    LeaveFixedWidth();
+  }
+  if (key_width_ != 0) {
+    value_offsets_.push_back(buffer_.size());
+    AddOrdinal(key, value_offsets_.size() - 1);
+    keys_.append(key.data(), key.size());
+    buffer_.append(value.data(), value.size());
+    last_key_.assign(key.data(), key.size());
+    return;
+  }
+  Slice last_key_piece(last_key_);
   size_t shared = 0;
   if (counter_ < options_->block_restart_interval) {
     // See how much sharing to do with previous string
@@ -214,6 +436,9 @@ void BlockBuilder::Add(const Slice& key, const Slice& value) {
     counter_ = 0;
   }
   const size_t non_shared = key.size() - shared;
+  if (counter_ == 0) {
+    AddOrdinal(key, restarts_.size() - 1);
+  }
 
   // Add "<shared><non_shared><value_size>" to buffer_
   PutVarint32(&buffer_, shared);
@@ -9,10 +9,13 @@
 #include <vector>
 
 #include "leveldb/slice.h"
+#include "util/piecewise_linear.h"
+#include "util/radix_spline.h"
 
 namespace leveldb {
 
 struct Options;
+struct TableModelStats;
 
 class BlockBuilder {
  public:
@@ -30,27 +33,78 @@ class BlockBuilder {
 
   // Finish building the block and return a slice that refers to the
   // block contents.  The returned slice will remain valid for the
-  // lifetime of this builder or until Reset() is called.
-  Slice Finish();
+  // lifetime of this builder or until Reset() is called.  If "stats" is
+  // non-null, the block and the errors of its search model are added to
+  // it.
+  Slice Finish(TableModelStats* stats = nullptr);
 
   // Returns an estimate of the current (uncompressed) size of the block
-  // we are building.
+  // we are building.  Under kAdaptiveSearch it assumes the block keeps its
+  // SLR model, so the finished block may be a little smaller.
   size_t CurrentSizeEstimate() const;
 
   // Return true iff no entries have been added since the last Reset()
-  bool empty() const { return buffer_.empty(); }
+  bool empty() const { return buffer_.empty() && keys_.empty(); }
 
  private:
-  const Options* options_; 
+  // Returns the key width of fixed-width blocks built with "options", or 0
+  // if they build blocks of the usual format.
+  static size_t KeyWidth(const Options* options);
+
+  // Rebuilds the fixed-width block built so far in the usual format, for
+  // a key whose width does not match.  The rest of the block is built in
+  // the usual format too.
+  void LeaveFixedWidth();
+
+  // Number of restart points, or of entries in a fixed-width block: the
+  // positions that search models predict.
+  size_t NumSlots() const;
+
+  // Returns true iff Add() should record the ordinals of restart keys.
+  bool CollectOrdinals() const;
+
+  // Records the ordinal of "key", the key at position "slot", for the
+  // search model.
+  void AddOrdinal(const Slice& key, size_t slot);
+
+  // Appends the search model and its trailer to buffer_ if the block gets
+  // one.  Returns true iff it did.  Adds the model's errors to "stats" if
+  // it is non-null and the model predicts positions.
+  bool AppendModel(TableModelStats* stats);
+
+  // Returns true iff the block's restart runs are long enough for a search
+  // model to pay off within them.
+  bool LongRuns() const;
+
+  // Returns true iff Finish() should fit a search model for this block.
+  bool UseModel() const;
+
+  // Size in bytes of the search model Finish() would append.
+  size_t ModelSize() const;
+
+  // Size in bytes of the SLR model Finish() would append.
+  size_t SLRModelSize() const;
+
+  // Size in bytes of the RadixSpline model Finish() would append, taking
+  // the stored error to be epsilon.
+  size_t RadixSplineModelSize() const;
+
+  const Options* options_;
   std::string buffer_;              // Destination buffer
   std::vector<uint32_t> restarts_;  // Restart points
+  PiecewiseLinearFitter fitter_;    // Fitted over ordinals of restart keys
+  size_t closed_segments_;          // Closed segments counted in model_bytes_
+  size_t model_bytes_;              // Encoded length of those segments
+  RadixSplineBuilder spline_;       // Only fed under kRadixSplineSearch
+  size_t spline_knots_;             // Knots counted in spline_bytes_
+  size_t spline_bytes_;             // Encoded length of those knots
+  size_t key_width_;                // Nonzero iff building a fixed-width block
+  bool prefix_only_;                // Build this block in the usual format
+  std::string keys_;                // Key array of a fixed-width block
+  std::vector<uint32_t> value_offsets_;  // Value offsets of a fixed-width block
   int counter_;                     // Number of entries emitted since restart
   bool finished_;                   // Has Finish() been called?
   std::string last_key_;
-  
-  int new_meta_size = 32;   // total of meta in block builder (included num_restarts)
-  bool SLR = false;	 		// set to false to use default binary search         
-  bool debug = false;       // set to true to show the debug information  
 };
 
 }  // namespace leveldb
@@ -4,6 +4,9 @@
 
 #include "table/format.h"
 
+#include <algorithm>
+#include <cstdio>
+
 #include "leveldb/env.h"
 #include "port/port.h"
 #include "table/block.h"
@@ -61,6 +64,182 @@ Status Footer::DecodeFrom(Slice* input) {
   return result;
 }
 
+size_t SLRSegmentLength(const LinearSegment& segment, uint64_t base) {
+  return VarintLength(segment.first_key - base) +
+         VarintLength(segment.key_span) +
+         VarintLength(segment.position_span) +
+         VarintLength(segment.max_error);
+}
+
+void EncodeSLRModel(const std::vector<LinearSegment>& segments,
+                    std::string* dst) {
+  PutVarint32(dst, segments.size());
+  uint64_t base = 0;
+  for (const LinearSegment& segment : segments) {
+    assert(segment.first_key >= base);
+    PutVarint64(dst, segment.first_key - base);
+    PutVarint64(dst, segment.key_span);
+    PutVarint32(dst, segment.position_span);
+    PutVarint32(dst, segment.max_error);
+    base = segment.first_key + segment.key_span;
+  }
+}
+
+bool DecodeSLRModel(Slice input, uint32_t num_restarts,
+                    std::vector<LinearSegment>* segments) {
+  uint32_t count;
+  if (!GetVarint32(&input, &count) || count == 0 || count > num_restarts) {
+    return false;
+  }
+  segments->resize(count);
+  uint64_t base = 0;
+  uint32_t position = 0;
+  for (LinearSegment& segment : *segments) {
+    uint64_t delta;
+    if (position >= num_restarts || !GetVarint64(&input, &delta) ||
+        !GetVarint64(&input, &segment.key_span) ||
+        !GetVarint32(&input, &segment.position_span) ||
+        !GetVarint32(&input, &segment.max_error) ||
+        delta > ~base || segment.key_span > ~(base + delta) ||
+        segment.position_span >= num_restarts - position) {
+      return false;
+    }
+    segment.first_key = base + delta;
+    segment.first_position = position;
+    segment.slope = SegmentSlope(segment.key_span, segment.position_span);
+    base = segment.first_key + segment.key_span;
+    position += segment.position_span + 1;
+  }
+  return input.empty() && position == num_restarts;
+}
+
+void EncodeInterpolationModel(uint64_t first, uint64_t last, std::string* dst) {
+  assert(first <= last);
+  PutVarint64(dst, first);
+  PutVarint64(dst, last - first);
+}
+
+bool DecodeInterpolationModel(Slice input, uint64_t* first, uint64_t* last) {
+  uint64_t span;
+  if (!GetVarint64(&input, first) || !GetVarint64(&input, &span) ||
+      span > ~*first) {
+    return false;
+  }
+  *last = *first + span;
+  return input.empty();
+}
+
+size_t SplinePointLength(const SplinePoint& point, const SplinePoint& prev) {
+  return VarintLength(point.key - prev.key) +
+         VarintLength(point.position - prev.position);
+}
+
+void EncodeRadixSplineModel(const std::vector<SplinePoint>& points,
+                            int radix_bits, uint32_t max_error,
+                            std::string* dst) {
+  assert(radix_bits >= 1 && radix_bits <= kMaxRadixBits);
+  dst->push_back(static_cast<char>(radix_bits));
+  PutVarint32(dst, max_error);
+  PutVarint32(dst, points.size());
+  SplinePoint prev{0, 0};
+  for (const SplinePoint& point : points) {
+    assert(point.key >= prev.key && point.position >= prev.position);
+    PutVarint64(dst, point.key - prev.key);
+    PutVarint32(dst, point.position - prev.position);
+    prev = point;
+  }
+}
+
+bool DecodeRadixSplineModel(Slice input, uint32_t num_restarts,
+                            std::vector<SplinePoint>* points, int* radix_bits,
+                            uint32_t* max_error) {
+  uint32_t count;
+  if (input.empty()) {
+    return false;
+  }
+  *radix_bits = static_cast<uint8_t>(input[0]);
+  input.remove_prefix(1);
+  if (*radix_bits < 1 || *radix_bits > kMaxRadixBits ||
+      !GetVarint32(&input, max_error) || !GetVarint32(&input, &count) ||
+      count == 0 || count > num_restarts) {
+    return false;
+  }
+  points->resize(count);
+  SplinePoint prev{0, 0};
+  for (uint32_t i = 0; i < count; i++) {
+    uint64_t key_delta;
+    uint32_t position_delta;
+    if (!GetVarint64(&input, &key_delta) ||
+        !GetVarint32(&input, &position_delta) ||
+        (i > 0 && key_delta == 0) || key_delta > ~prev.key ||
+        position_delta >= num_restarts - prev.position) {
+      return false;
+    }
+    prev.key += key_delta;
+    prev.position += position_delta;
+    (*points)[i] = prev;
+  }
+  return input.empty();
+}
+
+void TableModelStats::AddError(uint32_t error) {
+  keys++;
+  total += error;
+  max = std::max<uint64_t>(max, error);
+  histogram[std::min<uint32_t>(error, kModelErrorBuckets - 1)]++;
+}
+
+void TableModelStats::EncodeTo(std::string* dst) const {
+  PutVarint64(dst, blocks);
+  PutVarint64(dst, modeled_blocks);
+  PutVarint64(dst, early_cuts);
+  PutVarint64(dst, grown_blocks);
+  PutVarint64(dst, segments);
+  PutVarint64(dst, keys);
+  PutVarint64(dst, total);
+  PutVarint64(dst, max);
+  for (int i = 0; i < kModelErrorBuckets; i++) {
+    PutVarint64(dst, histogram[i]);
+  }
+}
+
+Status TableModelStats::DecodeFrom(Slice* input) {
+  bool ok = GetVarint64(input, &blocks) &&
+            GetVarint64(input, &modeled_blocks) &&
+            GetVarint64(input, &early_cuts) &&
+            GetVarint64(input, &grown_blocks) &&
+            GetVarint64(input, &segments) && GetVarint64(input, &keys) &&
+            GetVarint64(input, &total) && GetVarint64(input, &max);
+  for (int i = 0; ok && i < kModelErrorBuckets; i++) {
+    ok = GetVarint64(input, &histogram[i]);
+  }
+  return ok ? Status::OK() : Status::Corruption("bad block model stats");
+}
+
+std::string TableModelStats::ToString() const {
+  char buf[250];
+  std::snprintf(buf, sizeof(buf),
+                "%llu of %llu blocks modeled (%llu cut early, %llu grown) "
+                "with %llu segments; %.3f mean, %llu max error over %llu "
+                "keys; errors",
+                static_cast<unsigned long long>(modeled_blocks),
+                static_cast<unsigned long long>(blocks),
+                static_cast<unsigned long long>(early_cuts),
+                static_cast<unsigned long long>(grown_blocks),
+                static_cast<unsigned long long>(segments),
+                keys == 0 ? 0.0 : static_cast<double>(total) / keys,
+                static_cast<unsigned long long>(max),
+                static_cast<unsigned long long>(keys));
+  std::string result = buf;
+  for (int i = 0; i < kModelErrorBuckets; i++) {
+    std::snprintf(buf, sizeof(buf), " %d%s:%llu", i,
+                  i == kModelErrorBuckets - 1 ? "+" : "",
+                  static_cast<unsigned long long>(histogram[i]));
+    result += buf;
+  }
+  return result;
+}
+
 Status ReadBlock(RandomAccessFile* file, const ReadOptions& options,
                  const BlockHandle& handle, BlockContents* result) {
   result->data = Slice();
@@ -7,10 +7,13 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "leveldb/slice.h"
 #include "leveldb/status.h"
 #include "leveldb/table_builder.h"
+#include "util/piecewise_linear.h"
+#include "util/radix_spline.h"
 
 namespace leveldb {
 
@@ -78,6 +81,143 @@ static const uint64_t kTableMagicNumber = 0xdb4775248b80fb57ull;
 // 1-byte type + 32-bit crc
 static const size_t kBlockTrailerSize = 5;
 
+// The most significant bit of the restart count stored at the end of a
+// block is set when a search model sits between the restart array and
+// the restart count:
+//     model: char[model_size]
+//     model_size: fixed32
+//     model_type: uint8
+// Blocks without a model use the original layout.  Readers ignore models
+// of a type they do not know.
+static const uint32_t kBlockModelFlag = 0x80000000u;
+
+// The second most significant bit of the entry count stored at the end of
+// a block is set for fixed-width blocks (see Options::fixed_width_blocks):
+//     values: char[]                       every value, in order
+//     keys: char[num_entries * key_width]  every key, in order
+//     value_offsets: fixed32[num_entries]  offset of each value in the block
+//     key_width: fixed32
+//     (the model trailer, if kBlockModelFlag is set)
+//     num_entries: fixed32                 flags in the top two bits
+// A value ends where the next one starts, the last one where the keys
+// start.  Search models of fixed-width blocks predict entries rather than
+// restart points.
+static const uint32_t kBlockFixedWidthFlag = 0x40000000u;
+
+// Bytes the model adds to a block besides the model itself.
+static const size_t kBlockModelTrailerSize = sizeof(uint32_t) + 1;
+
+enum BlockModelType : uint8_t {
+  // Segmented linear regression over the restart keys.  The model is a
+  // varint32 segment count followed by the segments in order of position,
+  // each encoded as
+  //     first_ordinal: varint64  distance from the previous segment's last
+  //                              restart key ordinal (from 0 for the first)
+  //     ordinal_span: varint64   ordinal distance to its last restart key
+  //     restart_span: varint32   number of restart points between the two
+  //     max_error: varint32      largest prediction error over its restarts
+  // Segment i starts at the restart point after segment i-1 ends.
+  kSLRModel = 0x1,
+  // Interpolation search between the restart keys (see
+  // table/interpolation_search.h).  The model holds the ordinals of the
+  // first and last restart keys, which seed the first probe:
+  //     first_ordinal: varint64
+  //     ordinal_span: varint64   last ordinal minus first_ordinal
+  kInterpolationModel = 0x2,
+  // RadixSpline over the restart keys (see util/radix_spline.h).  The
+  // spline's knots are (restart key ordinal, restart point) pairs; the
+  // radix table over them is rebuilt when the block is loaded:
+  //     radix_bits: uint8       bits of the ordinals the radix table indexes
+  //     max_error: varint32     largest prediction error over the restarts
+  //     count: varint32         number of knots
+  // followed by the knots in order, each encoded as
+  //     ordinal: varint64       distance from the previous knot's ordinal
+  //                             (from 0 for the first)
+  //     restart: varint32       distance from the previous knot's restart
+  //                             point (from 0 for the first)
+  kRadixSplineModel = 0x3,
+};
+
+// Key in the metaindex block of a table's learned index.  Its value is the
+// handle of a meta block holding a kSLRModel model from the ordinal of the
+// last key in each data block to the block's number, which is also the
+// position of its entry in the index block.
+static const char kIndexModelName[] = "index.slr";
+
+// Key in the metaindex block of a table's learned index when it is a
+// kRadixSplineModel model.  A table holds at most one learned index.
+static const char kIndexSplineName[] = "index.radixspline";
+
+// Key in the metaindex block of the TableModelStats of a table's data
+// blocks.  Only tables built with search models have it.
+static const char kModelStatsName[] = "stats.blockmodel";
+
+// Length of the kSLRModel encoding of "segment" when the previous
+// segment's last key is "base".
+size_t SLRSegmentLength(const LinearSegment& segment, uint64_t base);
+
+// Append the kSLRModel encoding of "segments" to *dst.
+void EncodeSLRModel(const std::vector<LinearSegment>& segments,
+                    std::string* dst);
+
+// Parse a kSLRModel model for a block with "num_restarts" restart points.
+// Returns false if "input" is not a valid model for the block.
+bool DecodeSLRModel(Slice input, uint32_t num_restarts,
+                    std::vector<LinearSegment>* segments);
+
+// Append the kInterpolationModel encoding of a block whose restart keys
+// span ordinals [first, last] to *dst.
+void EncodeInterpolationModel(uint64_t first, uint64_t last, std::string* dst);
+
+// Parse a kInterpolationModel model.  Returns false if "input" is invalid.
+bool DecodeInterpolationModel(Slice input, uint64_t* first, uint64_t* last);
+
+// Length of the kRadixSplineModel encoding of knot "point" after "prev".
+size_t SplinePointLength(const SplinePoint& point, const SplinePoint& prev);
+
+// Append the kRadixSplineModel encoding of the spline through "points" to
+// *dst.
+void EncodeRadixSplineModel(const std::vector<SplinePoint>& points,
+                            int radix_bits, uint32_t max_error,
+                            std::string* dst);
+
+// Parse a kRadixSplineModel model for a block with "num_restarts" restart
+// points.  Returns false if "input" is not a valid model for the block.
+bool DecodeRadixSplineModel(Slice input, uint32_t num_restarts,
+                            std::vector<SplinePoint>* points, int* radix_bits,
+                            uint32_t* max_error);
+
+// Number of buckets in TableModelStats::histogram.
+static const int kModelErrorBuckets = 9;
+
+// Distribution of the prediction errors of the search models in a table's
+// data blocks, measured over the positions they were fitted to (restart
+// points, or entries of fixed-width blocks).  Stored in the table's
+// kModelStatsName meta block as a sequence of varint64s, one per field in
+// order of declaration.
+struct TableModelStats {
+  uint64_t blocks = 0;          // Data blocks
+  uint64_t modeled_blocks = 0;  // Data blocks with an SLR model or RadixSpline
+  uint64_t early_cuts = 0;      // Blocks ended short of block_size at a gap
+  uint64_t grown_blocks = 0;    // Blocks let grow past block_size
+  uint64_t segments = 0;        // SLR segments or RadixSpline knots
+  uint64_t keys = 0;            // Positions measured in modeled blocks
+  uint64_t total = 0;           // Sum of their prediction errors
+  uint64_t max = 0;             // Largest prediction error
+  // histogram[i] counts the positions predicted i positions off; the last
+  // bucket also counts larger errors.
+  uint64_t histogram[kModelErrorBuckets] = {};
+
+  // Count a position predicted "error" positions off.
+  void AddError(uint32_t error);
+
+  void EncodeTo(std::string* dst) const;
+  Status DecodeFrom(Slice* input);
+
+  // A one-line summary of the counts and the error distribution.
+  std::string ToString() const;
+};
+
 struct BlockContents {
   Slice data;           // Actual contents of data
   bool cachable;        // True iff data can be cached
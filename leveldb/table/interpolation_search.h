@@ -0,0 +1,75 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#ifndef STORAGE_LEVELDB_TABLE_INTERPOLATION_SEARCH_H_
+#define STORAGE_LEVELDB_TABLE_INTERPOLATION_SEARCH_H_
+
+#include <algorithm>
+#include <cstdint>
+
+namespace leveldb {
+
+// Guarded interpolation search over "n" sorted positions for the last one
+// whose key is < a target with ordinal "target".  "first" and "last" are
+// the ordinals of the keys at positions 0 and n-1.
+//
+// probe(i, &less, &ordinal) compares the key at position i with the target
+// and projects it to its ordinal; it returns false to abort the search.
+// Each probe goes where the target falls on the line between the ordinals
+// at the ends of the remaining range, rounded down, so a good guess is
+// confirmed by the probe after it.  Two probes in a row that fail to
+// halve the range are followed by a bisection, which keeps skewed keys
+// within about three times the probes of a binary search.
+//
+// Stores the answer, or 0 if no key is < the target, in *left.  Returns
+// false iff a probe failed.
+template <typename Probe>
+bool InterpolationSearch(uint32_t n, uint64_t first, uint64_t last,
+                         uint64_t target, Probe&& probe, uint32_t* left) {
+  *left = 0;
+  uint32_t right = n - 1;
+  uint64_t low = first;
+  uint64_t high = last;
+  int misses = 0;
+  while (*left < right) {
+    const uint32_t range = right - *left;
+    uint32_t mid;
+    if (misses >= 2) {
+      mid = *left + (range + 1) / 2;
+    } else if (target <= low) {
+      mid = *left + 1;
+    } else if (target >= high) {
+      mid = right;
+    } else {
+      // offset <= range because target < high
+      const double fraction = static_cast<double>(target - low) /
+                              static_cast<double>(high - low);
+      const uint32_t offset = static_cast<uint32_t>(fraction * range);
+      mid = *left + std::max<uint32_t>(offset, 1);
+    }
+
+    bool less;
+    uint64_t ordinal;
+    if (!probe(mid, &less, &ordinal)) {
+      return false;
+    }
+    if (less) {
+      *left = mid;
+      low = ordinal;
+    } else {
+      right = mid - 1;
+      high = ordinal;
+    }
+    if (misses >= 2 || (right - *left) <= range / 2) {
+      misses = 0;
+    } else {
+      misses++;
+    }
+  }
+  return true;
+}
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_TABLE_INTERPOLATION_SEARCH_H_
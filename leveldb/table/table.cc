@@ -36,6 +36,8 @@ struct Table::Rep {
 
   BlockHandle metaindex_handle;  // Handle to metaindex_block: saved from footer
   Block* index_block;
+  bool has_model_stats;
+  TableModelStats model_stats;
 };
 
 Status Table::Open(const Options& options, RandomAccessFile* file,
@@ -84,6 +86,7 @@ Status Table::Open(const Options& options, RandomAccessFile* file,
     rep->cache_id = (options.block_cache ? options.block_cache->NewId() : 0);
     rep->filter_data = nullptr;
     rep->filter = nullptr;
+    rep->has_model_stats = false;
     *table = new Table(rep);
     (*table)->ReadMeta(footer);
   }
@@ -95,7 +98,8 @@ Status Table::Open(const Options& options, RandomAccessFile* file,
 
 void Table::ReadMeta(const Footer& footer) {
 	
-  if (rep_->options.filter_policy == nullptr) {
+  if (rep_->options.filter_policy == nullptr &&
+      rep_->options.key_projection == nullptr) {
 	  // cout << "Do not need any metadata " << endl;
     return;  // Do not need any metadata
   }
@@ -118,15 +122,32 @@ void Table::ReadMeta(const Footer& footer) {
   Block* meta = new Block(contents);
 
   Iterator* iter = meta->NewIterator(BytewiseComparator());
-  std::string key = "filter.";
-  key.append(rep_->options.filter_policy->Name());
-  
-  // cout << "key.append " << rep_->options.filter_policy->Name() << endl;
-  // cout << "key.append Seek(key) " << key << endl;
-  iter->Seek(key);
-  if (iter->Valid() && iter->key() == Slice(key)) {
-	  // cout << "ReadFilter(iter->value()); " << endl;
-    ReadFilter(iter->value());
+  if (rep_->options.filter_policy != nullptr) {
+    std::string key = "filter.";
+    key.append(rep_->options.filter_policy->Name());
+
+    // cout << "key.append " << rep_->options.filter_policy->Name() << endl;
+    // cout << "key.append Seek(key) " << key << endl;
+    iter->Seek(key);
+    if (iter->Valid() && iter->key() == Slice(key)) {
+      // cout << "ReadFilter(iter->value()); " << endl;
+      ReadFilter(iter->value());
+    }
+  }
+  if (rep_->options.key_projection != nullptr) {
+    // Without a projection the learned index could not be used anyway
+    iter->Seek(kIndexModelName);
+    if (iter->Valid() && iter->key() == Slice(kIndexModelName)) {
+      ReadIndexModel(kSLRModel, iter->value());
+    }
+    iter->Seek(kIndexSplineName);
+    if (iter->Valid() && iter->key() == Slice(kIndexSplineName)) {
+      ReadIndexModel(kRadixSplineModel, iter->value());
+    }
+    iter->Seek(kModelStatsName);
+    if (iter->Valid() && iter->key() == Slice(kModelStatsName)) {
+      ReadModelStats(iter->value());
+    }
   }
   delete iter;
   delete meta;
@@ -162,6 +183,59 @@ void Table::ReadFilter(const Slice& filter_handle_value) {
   rep_->filter = new FilterBlockReader(rep_->options.filter_policy, block.data);
 }
 
+void Table::ReadIndexModel(BlockModelType type,
+                           const Slice& index_model_handle_value) {
+  Slice v = index_model_handle_value;
+  BlockHandle handle;
+  if (!handle.DecodeFrom(&v).ok()) {
+    return;
+  }
+
+  ReadOptions opt;
+  if (rep_->options.paranoid_checks) {
+    opt.verify_checksums = true;
+  }
+  BlockContents block;
+  if (!ReadBlock(rep_->file, opt, handle, &block).ok()) {
+    return;
+  }
+  // The index block keeps its own binary search if the model is bad
+  rep_->index_block->AttachModel(type, block.data);
+  if (block.heap_allocated) {
+    delete[] block.data.data();
+  }
+}
+
+void Table::ReadModelStats(const Slice& model_stats_handle_value) {
+  Slice v = model_stats_handle_value;
+  BlockHandle handle;
+  if (!handle.DecodeFrom(&v).ok()) {
+    return;
+  }
+
+  ReadOptions opt;
+  if (rep_->options.paranoid_checks) {
+    opt.verify_checksums = true;
+  }
+  BlockContents block;
+  if (!ReadBlock(rep_->file, opt, handle, &block).ok()) {
+    return;
+  }
+  Slice input = block.data;
+  rep_->has_model_stats = rep_->model_stats.DecodeFrom(&input).ok();
+  if (block.heap_allocated) {
+    delete[] block.data.data();
+  }
+}
+
+bool Table::GetModelStats(TableModelStats* stats) const {
+  if (!rep_->has_model_stats) {
+    return false;
+  }
+  *stats = rep_->model_stats;
+  return true;
+}
+
 Table::~Table() { delete rep_; }
 
 static void DeleteBlock(void* arg, void* ignored) {
@@ -193,9 +267,6 @@ Iterator* Table::BlockReader(void* arg, const ReadOptions& options,
   Status s = handle.DecodeFrom(&input);
   // We intentionally allow extra stuff in index_value so that we
   // can add more features in the future.
-  
-  std::string inputs = input.ToString();
-	// cout << "input :" << inputs << endl;
 
   if (s.ok()) {
     BlockContents contents;
@@ -212,7 +283,8 @@ Iterator* Table::BlockReader(void* arg, const ReadOptions& options,
         if (s.ok()) {
           block = new Block(contents);
           if (contents.cachable && options.fill_cache) {
-            cache_handle = block_cache->Insert(key, block, block->size(),
+            cache_handle = block_cache->Insert(key, block,
+                                               block->ApproximateMemoryUsage(),
                                                &DeleteCachedBlock);
           }
         }
@@ -227,7 +299,8 @@ Iterator* Table::BlockReader(void* arg, const ReadOptions& options,
 
   Iterator* iter;
   if (block != nullptr) {
-    iter = block->NewIterator(table->rep_->options.comparator);
+    iter = block->NewIterator(table->rep_->options.comparator,
+                              table->rep_->options.key_projection);
     if (cache_handle == nullptr) {
       iter->RegisterCleanup(&DeleteBlock, block, nullptr);
     } else {
@@ -241,7 +314,8 @@ Iterator* Table::BlockReader(void* arg, const ReadOptions& options,
 
 Iterator* Table::NewIterator(const ReadOptions& options) const {
   return NewTwoLevelIterator(
-      rep_->index_block->NewIterator(rep_->options.comparator),
+      rep_->index_block->NewIterator(rep_->options.comparator,
+                                     rep_->options.key_projection),
       &Table::BlockReader, const_cast<Table*>(this), options);
 }
 
@@ -249,9 +323,8 @@ Status Table::InternalGet(const ReadOptions& options, const Slice& k, void* arg,
                           void (*handle_result)(void*, const Slice&,
                                                 const Slice&)) {
   Status s;
-  Iterator* iiter = rep_->index_block->NewIterator(rep_->options.comparator);
-  std::string kkk= k.ToString();
-  // cout << "InternalGet : " << kkk << endl;
+  Iterator* iiter = rep_->index_block->NewIterator(
+      rep_->options.comparator, rep_->options.key_projection);
   iiter->Seek(k);
   if (iiter->Valid()) {
     Slice handle_value = iiter->value();
@@ -261,8 +334,6 @@ Status Table::InternalGet(const ReadOptions& options, const Slice& k, void* arg,
         !filter->KeyMayMatch(handle.offset(), k)) {
       // Not found
     } else {
-		
-		// cout << "InternalGet : " << kkk << endl;
       Iterator* block_iter = BlockReader(this, options, iiter->value());
       block_iter->Seek(k);
       if (block_iter->Valid()) {
@@ -281,7 +352,8 @@ Status Table::InternalGet(const ReadOptions& options, const Slice& k, void* arg,
 
 uint64_t Table::ApproximateOffsetOf(const Slice& key) const {
   Iterator* index_iter =
-      rep_->index_block->NewIterator(rep_->options.comparator);
+      rep_->index_block->NewIterator(rep_->options.comparator,
+                                     rep_->options.key_projection);
   index_iter->Seek(key);
   uint64_t result;
   if (index_iter->Valid()) {
@@ -9,18 +9,33 @@
 #include "leveldb/comparator.h"
 #include "leveldb/env.h"
 #include "leveldb/filter_policy.h"
+#include "leveldb/key_projection.h"
 #include "leveldb/options.h"
 #include "table/block_builder.h"
 #include "table/filter_block.h"
 #include "table/format.h"
 #include "util/coding.h"
 #include "util/crc32c.h"
+#include "util/piecewise_linear.h"
+#include "util/radix_spline.h"
 
 #include<iostream>
 using namespace std;
 
 namespace leveldb {
 
+namespace {
+
+// Under Options::model_block_boundaries, data blocks end within
+// block_size / kBoundarySlack of block_size ...
+constexpr size_t kBoundarySlack = 8;
+
+// ... before a key whose ordinal gap from the previous key is more than
+// this many times the mean gap of the block.
+constexpr uint64_t kBoundaryGapFactor = 4;
+
+}  // namespace
+
 struct TableBuilder::Rep {
   Rep(const Options& opt, WritableFile* f)
       : options(opt),
@@ -34,8 +49,101 @@ struct TableBuilder::Rep {
         filter_block(opt.filter_policy == nullptr
                          ? nullptr
                          : new FilterBlockBuilder(opt.filter_policy)),
-        pending_index_entry(false) {
+        pending_index_entry(false),
+        index_model(opt.block_search_epsilon),
+        index_spline(opt.block_search_epsilon),
+        index_model_complete(true),
+        block_first_ordinal(0),
+        block_last_ordinal(0),
+        block_keys(0),
+        block_gaps_known(false),
+        block_grown(false) {
     index_block_options.block_restart_interval = 1;
+    // The learned index meta block takes the place of an index block model.
+    index_block_options.block_search_mode = kBinarySearch;
+    // Separators need not have the comparator's fixed key width.
+    index_block_options.fixed_width_blocks = false;
+  }
+
+  // Returns true iff the table gets a learned index over its index block.
+  bool UseIndexModel() const {
+    return options.block_search_mode != kBinarySearch &&
+           options.key_projection != nullptr;
+  }
+
+  // Returns true iff data block boundaries follow the keys' ordinals.
+  bool UseModelBoundaries() const {
+    return options.model_block_boundaries && UseIndexModel();
+  }
+
+  // Returns true iff the data block should end before a key with
+  // "ordinal" under Options::model_block_boundaries.
+  bool EndBlockBefore(uint64_t ordinal) {
+    if (data_block.empty()) {
+      return false;
+    }
+    const size_t size = data_block.CurrentSizeEstimate();
+    const size_t slack = options.block_size / kBoundarySlack;
+    if (size + slack < options.block_size) {
+      return false;
+    }
+    if (size >= options.block_size + slack || !block_gaps_known ||
+        block_keys < 2 || ordinal < block_last_ordinal) {
+      return size >= options.block_size;
+    }
+    const uint64_t mean_gap =
+        (block_last_ordinal - block_first_ordinal) / (block_keys - 1);
+    const bool large_gap =
+        (ordinal - block_last_ordinal) / kBoundaryGapFactor > mean_gap;
+    if (size < options.block_size) {
+      model_stats.early_cuts += large_gap;
+    } else {
+      block_grown |= !large_gap;
+    }
+    return large_gap;
+  }
+
+  // Record "ordinal" as that of the key just added to the data block.
+  void AddBlockOrdinal(uint64_t ordinal) {
+    if (block_keys == 0) {
+      block_first_ordinal = ordinal;
+      block_gaps_known = true;
+    } else if (ordinal < block_last_ordinal) {
+      // Not monotone over this block
+      block_gaps_known = false;
+    }
+    block_last_ordinal = ordinal;
+    block_keys++;
+  }
+
+  // Add the index entry for the data block at pending_handle, whose last
+  // key is last_key.  "next_key" is the first key of the next data block,
+  // or nullptr if there is none.
+  void AddIndexEntry(const Slice* next_key) {
+    // Fit the learned index to the block's last key rather than to the
+    // shortened separator, which a projection may not order correctly.
+    if (UseIndexModel() && index_model_complete) {
+      const uint64_t ordinal = options.key_projection->ToOrdinal(last_key);
+      if (index_model.num_keys() == 0 || ordinal >= index_model.last_key()) {
+        index_model.Add(ordinal);
+        if (options.block_search_mode == kRadixSplineSearch) {
+          index_spline.Add(ordinal);
+        }
+      } else {
+        // Not monotone over this table
+        index_model_complete = false;
+      }
+    }
+
+    if (next_key != nullptr) {
+      options.comparator->FindShortestSeparator(&last_key, *next_key);
+    } else {
+      options.comparator->FindShortSuccessor(&last_key);
+    }
+    std::string handle_encoding;
+    pending_handle.EncodeTo(&handle_encoding);
+    index_block.Add(last_key, Slice(handle_encoding));
+    pending_index_entry = false;
   }
 
   Options options;
@@ -63,6 +171,23 @@ struct TableBuilder::Rep {
   BlockHandle pending_handle;  // Handle to add to index block
 
   std::string compressed_output;
+
+  // Fitted over the ordinals of the last key of each data block, so that
+  // it predicts the number of the data block that may hold a key.
+  PiecewiseLinearFitter index_model;
+  RadixSplineBuilder index_spline;  // The same, under kRadixSplineSearch
+  bool index_model_complete;  // Every index key has been added to the model
+
+  TableModelStats model_stats;  // Over the data blocks written so far
+
+  // Under Options::model_block_boundaries: the ordinals of the first and
+  // last keys of the data block being built, its number of keys, whether
+  // its ordinals are non-decreasing, and whether it grew past block_size.
+  uint64_t block_first_ordinal;
+  uint64_t block_last_ordinal;
+  uint64_t block_keys;
+  bool block_gaps_known;
+  bool block_grown;
 };
 
 TableBuilder::TableBuilder(const Options& options, WritableFile* file)
@@ -91,6 +216,8 @@ Status TableBuilder::ChangeOptions(const Options& options) {
   rep_->options = options;
   rep_->index_block_options = options;
   rep_->index_block_options.block_restart_interval = 1;
+  rep_->index_block_options.block_search_mode = kBinarySearch;
+  rep_->index_block_options.fixed_width_blocks = false;
   return Status::OK();
 }
 
@@ -102,13 +229,18 @@ void TableBuilder::Add(const Slice& key, const Slice& value) {
     assert(r->options.comparator->Compare(key, Slice(r->last_key)) > 0);
   }
 
+  const bool model_boundaries = r->UseModelBoundaries();
+  uint64_t ordinal = 0;
+  if (model_boundaries) {
+    ordinal = r->options.key_projection->ToOrdinal(key);
+    if (r->EndBlockBefore(ordinal)) {
+      Flush();
+    }
+  }
+
   if (r->pending_index_entry) {
     assert(r->data_block.empty());
-    r->options.comparator->FindShortestSeparator(&r->last_key, key);
-    std::string handle_encoding;
-    r->pending_handle.EncodeTo(&handle_encoding);
-    r->index_block.Add(r->last_key, Slice(handle_encoding));
-    r->pending_index_entry = false;
+    r->AddIndexEntry(&key);
   }
 
   if (r->filter_block != nullptr) {
@@ -119,6 +251,11 @@ void TableBuilder::Add(const Slice& key, const Slice& value) {
   r->num_entries++;
   r->data_block.Add(key, value);
 
+  if (model_boundaries) {
+    // The next key decides where the block ends
+    r->AddBlockOrdinal(ordinal);
+    return;
+  }
   const size_t estimated_block_size = r->data_block.CurrentSizeEstimate();
   if (estimated_block_size >= r->options.block_size) {
     Flush();
@@ -132,6 +269,9 @@ void TableBuilder::Flush() {
   if (r->data_block.empty()) return;
   assert(!r->pending_index_entry);
   WriteBlock(&r->data_block, &r->pending_handle);
+  r->model_stats.grown_blocks += r->block_grown;
+  r->block_keys = 0;
+  r->block_grown = false;
   if (ok()) {
     r->pending_index_entry = true;
     r->status = r->file->Flush();
@@ -148,7 +288,8 @@ void TableBuilder::WriteBlock(BlockBuilder* block, BlockHandle* handle) {
   //    crc: uint32
   assert(ok());
   Rep* r = rep_;
-  Slice raw = block->Finish();
+  Slice raw =
+      block->Finish(block == &r->data_block ? &r->model_stats : nullptr);
 
   Slice block_contents;
   CompressionType type = r->options.compression;
@@ -204,7 +345,13 @@ Status TableBuilder::Finish() {
   assert(!r->closed);
   r->closed = true;
 
-  BlockHandle filter_block_handle, metaindex_block_handle, index_block_handle;
+  BlockHandle filter_block_handle, index_model_handle, model_stats_handle,
+      metaindex_block_handle, index_block_handle;
+
+  // The learned index covers every index entry, so add the last one now
+  if (ok() && r->pending_index_entry) {
+    r->AddIndexEntry(nullptr);
+  }
 
   // Write filter block
   if (ok() && r->filter_block != nullptr) {
@@ -212,10 +359,44 @@ Status TableBuilder::Finish() {
                   &filter_block_handle);
   }
 
+  // Write learned index block
+  const bool use_index_model = r->UseIndexModel() &&
+                               r->index_model_complete &&
+                               r->index_model.num_keys() > 0;
+  // The spline is only complete if the search mode stayed the same
+  const bool use_index_spline =
+      use_index_model &&
+      r->options.block_search_mode == kRadixSplineSearch &&
+      r->index_spline.num_keys() == r->index_model.num_keys();
+  if (ok() && use_index_spline) {
+    std::vector<SplinePoint> knots;
+    r->index_spline.Finish(&knots);
+    std::string model;
+    EncodeRadixSplineModel(knots, RadixBitsFor(knots.size()),
+                           SplineError(knots, r->index_model.keys()), &model);
+    WriteRawBlock(model, kNoCompression, &index_model_handle);
+  } else if (ok() && use_index_model) {
+    std::vector<LinearSegment> segments;
+    r->index_model.Finish(&segments);
+    std::string model;
+    EncodeSLRModel(segments, &model);
+    WriteRawBlock(model, kNoCompression, &index_model_handle);
+  }
+
+  // Write the error distribution of the data block models
+  const bool write_model_stats = r->model_stats.modeled_blocks > 0;
+  if (ok() && write_model_stats) {
+    std::string stats;
+    r->model_stats.EncodeTo(&stats);
+    WriteRawBlock(stats, kNoCompression, &model_stats_handle);
+  }
+
 	// cout << "metabefore : " << endl;
   // Write metaindex block
   if (ok()) {
-    BlockBuilder meta_index_block(&r->options);
+    Options meta_index_options = r->options;
+    meta_index_options.fixed_width_blocks = false;
+    BlockBuilder meta_index_block(&meta_index_options);
     if (r->filter_block != nullptr) {
       // Add mapping from "filter.Name" to location of filter data
       std::string key = "filter.";
@@ -226,6 +407,18 @@ Status TableBuilder::Finish() {
 	  
 	  // cout << "std::string key : " << key << endl; 
     }
+    if (use_index_model) {
+      std::string handle_encoding;
+      index_model_handle.EncodeTo(&handle_encoding);
+      meta_index_block.Add(
+          use_index_spline ? kIndexSplineName : kIndexModelName,
+          handle_encoding);
+    }
+    if (write_model_stats) {
+      std::string handle_encoding;
+      model_stats_handle.EncodeTo(&handle_encoding);
+      meta_index_block.Add(kModelStatsName, handle_encoding);
+    }
 
     // TODO(postrelease): Add stats and other meta blocks
     WriteBlock(&meta_index_block, &metaindex_block_handle);
@@ -233,13 +426,6 @@ Status TableBuilder::Finish() {
 
   // Write index block
   if (ok()) {
-    if (r->pending_index_entry) {
-      r->options.comparator->FindShortSuccessor(&r->last_key);
-      std::string handle_encoding;
-      r->pending_handle.EncodeTo(&handle_encoding);
-      r->index_block.Add(r->last_key, Slice(handle_encoding));
-      r->pending_index_entry = false;
-    }
     WriteBlock(&r->index_block, &index_block_handle);
   }
 
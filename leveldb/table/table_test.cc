@@ -5,6 +5,7 @@
 #include "leveldb/table.h"
 
 #include <map>
+#include <set>
 #include <string>
 
 #include "gtest/gtest.h"
@@ -14,10 +15,12 @@
 #include "leveldb/db.h"
 #include "leveldb/env.h"
 #include "leveldb/iterator.h"
+#include "leveldb/key_projection.h"
 #include "leveldb/table_builder.h"
 #include "table/block.h"
 #include "table/block_builder.h"
 #include "table/format.h"
+#include "util/coding.h"
 #include "util/random.h"
 #include "util/testutil.h"
 
@@ -176,11 +179,15 @@ class Constructor {
 class BlockConstructor : public Constructor {
  public:
   explicit BlockConstructor(const Comparator* cmp)
-      : Constructor(cmp), comparator_(cmp), block_(nullptr) {}
+      : Constructor(cmp),
+        comparator_(cmp),
+        projection_(nullptr),
+        block_(nullptr) {}
   ~BlockConstructor() override { delete block_; }
   Status FinishImpl(const Options& options, const KVMap& data) override {
     delete block_;
     block_ = nullptr;
+    projection_ = options.key_projection;
     BlockBuilder builder(&options);
 
     for (const auto& kvp : data) {
@@ -196,11 +203,12 @@ class BlockConstructor : public Constructor {
     return Status::OK();
   }
   Iterator* NewIterator() const override {
-    return block_->NewIterator(comparator_);
+    return block_->NewIterator(comparator_, projection_);
   }
 
  private:
   const Comparator* const comparator_;
+  const KeyProjection* projection_;
   std::string data_;
   Block* block_;
 
@@ -230,6 +238,7 @@ class TableConstructor : public Constructor {
     source_ = new StringSource(sink.contents());
     Options table_options;
     table_options.comparator = options.comparator;
+    table_options.key_projection = options.key_projection;
     return Table::Open(table_options, source_, sink.contents().size(), &table_);
   }
 
@@ -299,8 +308,9 @@ class KeyConvertingIterator : public Iterator {
 
 class MemTableConstructor : public Constructor {
  public:
-  explicit MemTableConstructor(const Comparator* cmp)
-      : Constructor(cmp), internal_comparator_(cmp) {
+  // If "frozen" is true, the memtable is frozen once it is filled.
+  explicit MemTableConstructor(const Comparator* cmp, bool frozen = false)
+      : Constructor(cmp), internal_comparator_(cmp), frozen_(frozen) {
     memtable_ = new MemTable(internal_comparator_);
     memtable_->Ref();
   }
@@ -314,6 +324,9 @@ class MemTableConstructor : public Constructor {
       memtable_->Add(seq, kTypeValue, kvp.first, kvp.second);
       seq++;
     }
+    if (frozen_) {
+      memtable_->Freeze(nullptr, options.block_search_epsilon);
+    }
     return Status::OK();
   }
   Iterator* NewIterator() const override {
@@ -322,6 +335,7 @@ class MemTableConstructor : public Constructor {
 
  private:
   const InternalKeyComparator internal_comparator_;
+  const bool frozen_;
   MemTable* memtable_;
 };
 
@@ -330,13 +344,13 @@ class DBConstructor : public Constructor {
   explicit DBConstructor(const Comparator* cmp)
       : Constructor(cmp), comparator_(cmp) {
     db_ = nullptr;
-    NewDB();
+    NewDB(Options());
   }
   ~DBConstructor() override { delete db_; }
   Status FinishImpl(const Options& options, const KVMap& data) override {
     delete db_;
     db_ = nullptr;
-    NewDB();
+    NewDB(options);
     for (const auto& kvp : data) {
       WriteBatch batch;
       batch.Put(kvp.first, kvp.second);
@@ -351,11 +365,14 @@ class DBConstructor : public Constructor {
   DB* db() const override { return db_; }
 
  private:
-  void NewDB() {
+  // Opens a new DB that searches its blocks as "search_options" says.
+  void NewDB(const Options& search_options) {
     std::string name = testing::TempDir() + "table_testdb";
 
     Options options;
     options.comparator = comparator_;
+    options.block_search_mode = search_options.block_search_mode;
+    options.key_projection = search_options.key_projection;
     Status status = DestroyDB(name, options);
     ASSERT_TRUE(status.ok()) << status.ToString();
 
@@ -370,12 +387,19 @@ class DBConstructor : public Constructor {
   DB* db_;
 };
 
-enum TestType { TABLE_TEST, BLOCK_TEST, MEMTABLE_TEST, DB_TEST };
+enum TestType {
+  TABLE_TEST,
+  BLOCK_TEST,
+  MEMTABLE_TEST,
+  FROZEN_MEMTABLE_TEST,
+  DB_TEST
+};
 
 struct TestArgs {
   TestType type;
   bool reverse_compare;
   int restart_interval;
+  BlockSearchMode search_mode;  // Other modes search by the keys' prefixes
 };
 
 static const TestArgs kTestArgList[] = {
@@ -396,16 +420,31 @@ static const TestArgs kTestArgList[] = {
     // Restart interval does not matter for memtables
     {MEMTABLE_TEST, false, 16},
     {MEMTABLE_TEST, true, 16},
+    {FROZEN_MEMTABLE_TEST, false, 16},
+    {FROZEN_MEMTABLE_TEST, true, 16},
 
     // Do not bother with restart interval variations for DB
     {DB_TEST, false, 16},
     {DB_TEST, true, 16},
+
+    // Search models need a projection in comparator order, so only the
+    // bytewise comparator is used with them
+    {TABLE_TEST, false, 16, kSLRSearch},
+    {TABLE_TEST, false, 1, kAdaptiveSearch},
+    {TABLE_TEST, false, 16, kRadixSplineSearch},
+    {BLOCK_TEST, false, 16, kSLRSearch},
+    {BLOCK_TEST, false, 1, kAdaptiveSearch},
+    {BLOCK_TEST, false, 16, kRadixSplineSearch},
+    {DB_TEST, false, 16, kSLRSearch},
+    {DB_TEST, false, 16, kAdaptiveSearch},
+    {DB_TEST, false, 16, kRadixSplineSearch},
 };
 static const int kNumTestArgs = sizeof(kTestArgList) / sizeof(kTestArgList[0]);
 
 class Harness : public testing::Test {
  public:
-  Harness() : constructor_(nullptr) {}
+  Harness()
+      : projection_(NewPrefixKeyProjection()), constructor_(nullptr) {}
 
   void Init(const TestArgs& args) {
     delete constructor_;
@@ -419,6 +458,10 @@ class Harness : public testing::Test {
     if (args.reverse_compare) {
       options_.comparator = &reverse_key_comparator;
     }
+    if (args.search_mode != kBinarySearch) {
+      options_.block_search_mode = args.search_mode;
+      options_.key_projection = projection_;
+    }
     switch (args.type) {
       case TABLE_TEST:
         constructor_ = new TableConstructor(options_.comparator);
@@ -429,13 +472,19 @@ class Harness : public testing::Test {
       case MEMTABLE_TEST:
         constructor_ = new MemTableConstructor(options_.comparator);
         break;
+      case FROZEN_MEMTABLE_TEST:
+        constructor_ = new MemTableConstructor(options_.comparator, true);
+        break;
       case DB_TEST:
         constructor_ = new DBConstructor(options_.comparator);
         break;
     }
   }
 
-  ~Harness() { delete constructor_; }
+  ~Harness() {
+    delete constructor_;
+    delete projection_;
+  }
 
   void Add(const std::string& key, const std::string& value) {
     constructor_->Add(key, value);
@@ -604,6 +653,7 @@ class Harness : public testing::Test {
   DB* db() const { return constructor_->db(); }
 
  private:
+  const KeyProjection* const projection_;
   Options options_;
   Constructor* constructor_;
 };
@@ -721,6 +771,884 @@ TEST_F(Harness, RandomizedLongDB) {
   ASSERT_GT(files, 0);
 }
 
+static std::string DecimalKey(int k) {
+  char buf[20];
+  std::snprintf(buf, sizeof(buf), "%09d", k);
+  return std::string(buf);
+}
+
+static std::string BigEndianKey(uint64_t v, int width) {
+  std::string key;
+  for (int i = width - 1; i >= 0; i--) {
+    key.push_back(static_cast<char>(v >> (8 * i)));
+  }
+  return key;
+}
+
+// Builds a block of "keys" with "options", with "v" + key as each key's
+// value, and returns its contents.
+static std::string BuildBlock(const Options& options,
+                              const std::vector<std::string>& keys) {
+  BlockBuilder builder(&options);
+  for (const std::string& key : keys) {
+    builder.Add(key, "v" + key);
+  }
+  return builder.Finish().ToString();
+}
+
+// Returns contents pointing into "data", which must outlive any block
+// made from them.
+static BlockContents UnownedContents(const Slice& data) {
+  BlockContents contents;
+  contents.data = data;
+  contents.cachable = false;
+  contents.heap_allocated = false;
+  return contents;
+}
+
+// Builds a block of "keys" with "options" and checks that every key and
+// every gap between keys is found with Seek().  Stores the type of the
+// block's search model, or 0 if it has none, in *model_type if non-null.
+static void CheckSeekEveryKey(const Options& options,
+                              const std::vector<std::string>& keys,
+                              BlockSearchStats* stats = nullptr,
+                              int* model_type = nullptr) {
+  BlockBuilder builder(&options);
+  for (const std::string& key : keys) {
+    builder.Add(key, "v" + key);
+  }
+  const size_t estimate = builder.CurrentSizeEstimate();
+  std::string data = builder.Finish().ToString();
+  const bool has_model =
+      (DecodeFixed32(data.data() + data.size() - 4) & kBlockModelFlag) != 0;
+  const int type = has_model ? data[data.size() - 5] : 0;
+  if (model_type != nullptr) {
+    *model_type = type;
+  }
+  if (options.block_search_mode == kAdaptiveSearch) {
+    // The estimate assumes the SLR model is kept.
+    ASSERT_LE(data.size(), estimate);
+    ASSERT_EQ(type == kSLRModel, data.size() == estimate);
+  } else {
+    ASSERT_EQ(estimate, data.size());
+    ASSERT_EQ(options.block_search_mode != kBinarySearch, has_model);
+  }
+
+  Block block(UnownedContents(data));
+  // The decoded model is memory the block cache must charge for
+  ASSERT_EQ(type != 0, block.ApproximateMemoryUsage() > block.size());
+  BlockModelError error;
+  ASSERT_EQ(type == kSLRModel || type == kRadixSplineModel,
+            block.MeasureModelError(options.key_projection, &error));
+  if (type == kSLRModel) {
+    ASSERT_LE(error.max, options.block_search_epsilon);
+    ASSERT_LE(error.total, error.restarts * error.max);
+  } else if (type == kRadixSplineModel) {
+    // Spline predictions are rounded down after meeting epsilon
+    ASSERT_LE(error.max, options.block_search_epsilon + 1);
+    ASSERT_LE(error.total, error.restarts * error.max);
+  }
+
+  BlockSearchStats local_stats;
+  if (stats == nullptr) {
+    stats = &local_stats;
+  }
+  // Every seek starts from a fresh iterator, so that it searches the
+  // whole block rather than on from the previous key.
+  Iterator* iter;
+  for (size_t i = 0; i < keys.size(); i++) {
+    iter = block.NewIterator(options.comparator, options.key_projection, stats);
+    iter->Seek(keys[i]);
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(keys[i], iter->key().ToString());
+    ASSERT_EQ("v" + keys[i], iter->value().ToString());
+    delete iter;
+
+    // A missing key lands on its successor.
+    iter = block.NewIterator(options.comparator, options.key_projection, stats);
+    iter->Seek(keys[i] + '\0');
+    if (i + 1 < keys.size()) {
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(keys[i + 1], iter->key().ToString());
+    } else {
+      ASSERT_TRUE(!iter->Valid());
+    }
+    delete iter;
+  }
+  // Keys stay within the model's error bound.
+  ASSERT_EQ(0, stats->fallbacks);
+}
+
+TEST(BlockSearchModeTest, DecimalKeys) {
+  std::vector<std::string> keys;
+  for (int i = 0; i < 2000; i++) {
+    keys.push_back(DecimalKey(1000 + i * 7 + (i % 5)));
+  }
+  const KeyProjection* projection = NewDecimalKeyProjection();
+  const BlockSearchMode kModes[] = {kBinarySearch, kSLRSearch};
+  BlockSearchStats stats[2];
+  for (int i = 0; i < 2; i++) {
+    Options options;
+    options.block_search_mode = kModes[i];
+    options.key_projection = projection;
+    CheckSeekEveryKey(options, keys, &stats[i]);
+    ASSERT_EQ(2 * keys.size(), stats[i].seeks);
+  }
+  // The model narrows each seek to a few restart points.
+  ASSERT_LT(stats[1].probes, stats[0].probes);
+  delete projection;
+}
+
+TEST(BlockSearchModeTest, FixedWidthKeys) {
+  std::vector<std::string> keys;
+  for (uint64_t i = 0; i < 2000; i++) {
+    keys.push_back(BigEndianKey(3 * i * i + 11, 4));
+  }
+  const KeyProjection* projection = NewFixedWidthKeyProjection(4);
+  Options options;
+  options.block_search_mode = kSLRSearch;
+  options.key_projection = projection;
+  CheckSeekEveryKey(options, keys);
+  delete projection;
+}
+
+TEST(BlockSearchModeTest, PrefixKeys) {
+  Random rnd(301);
+  std::set<std::string> unique;
+  while (unique.size() < 2000) {
+    char buf[40];
+    std::snprintf(buf, sizeof(buf), "%08x:user%u", rnd.Next(), rnd.Next());
+    unique.insert(buf);
+  }
+  std::vector<std::string> keys(unique.begin(), unique.end());
+  const KeyProjection* projection = NewPrefixKeyProjection();
+  Options options;
+  options.block_search_mode = kSLRSearch;
+  options.key_projection = projection;
+  CheckSeekEveryKey(options, keys);
+  delete projection;
+}
+
+TEST(BlockSearchModeTest, FullUint64Range) {
+  // Keys spread over the whole 64-bit ordinal space, including both ends.
+  std::vector<std::string> keys;
+  const uint64_t kStep = ~static_cast<uint64_t>(0) / 1999;
+  for (uint64_t i = 0; i < 2000; i++) {
+    keys.push_back(BigEndianKey(i * kStep + (i % 3), 8));
+  }
+  keys.push_back(BigEndianKey(~static_cast<uint64_t>(0), 8));
+  const KeyProjection* projection = NewFixedWidthKeyProjection(8);
+  Options options;
+  options.block_search_mode = kSLRSearch;
+  options.key_projection = projection;
+  CheckSeekEveryKey(options, keys);
+
+  // Dense runs of keys far above 2^32, as in the Twitter user ids.
+  keys.clear();
+  for (uint64_t i = 0; i < 2000; i++) {
+    keys.push_back(BigEndianKey((uint64_t{1} << 40) + i * i, 8));
+  }
+  for (uint64_t i = 0; i < 2000; i++) {
+    keys.push_back(BigEndianKey((uint64_t{1} << 63) + 7 * i, 8));
+  }
+  CheckSeekEveryKey(options, keys);
+  delete projection;
+
+  // Decimal keys above 2^31 used to overflow the 32-bit model.
+  keys.clear();
+  for (uint64_t i = 0; i < 2000; i++) {
+    keys.push_back(std::to_string(10000000000000000000ull + i * 104729));
+  }
+  projection = NewDecimalKeyProjection();
+  options.key_projection = projection;
+  CheckSeekEveryKey(options, keys);
+  delete projection;
+}
+
+TEST(BlockSearchModeTest, SkewedKeys) {
+  // Dense bursts of keys separated by large gaps, so no small number of
+  // equal-count segments fits them.
+  Random rnd(301);
+  std::vector<std::string> keys;
+  uint64_t key = 0;
+  for (int i = 0; i < 3000; i++) {
+    key += 1 + (rnd.OneIn(50) ? rnd.Uniform(1 << 30) : rnd.Uniform(4));
+    keys.push_back(BigEndianKey(key, 8));
+  }
+  const KeyProjection* projection = NewFixedWidthKeyProjection(8);
+  for (int epsilon : {0, 1, 4, 64}) {
+    Options options;
+    options.block_search_mode = kSLRSearch;
+    options.key_projection = projection;
+    options.block_search_epsilon = epsilon;
+    options.block_restart_interval = 1 + epsilon % 3;
+    CheckSeekEveryKey(options, keys);
+  }
+  delete projection;
+}
+
+TEST(BlockSearchModeTest, AdaptiveSearch) {
+  const KeyProjection* projection = NewFixedWidthKeyProjection(8);
+  Options options;
+  options.key_projection = projection;
+  BlockSearchStats slr_stats, adaptive_stats;
+  int type;
+
+  // Evenly spaced keys are found as fast by interpolation as by an SLR
+  // model, which takes more space.
+  std::vector<std::string> keys;
+  for (uint64_t i = 0; i < 2000; i++) {
+    keys.push_back(BigEndianKey(1000 + 37 * i, 8));
+  }
+  options.block_search_mode = kSLRSearch;
+  CheckSeekEveryKey(options, keys, &slr_stats);
+  options.block_search_mode = kAdaptiveSearch;
+  CheckSeekEveryKey(options, keys, &adaptive_stats, &type);
+  ASSERT_EQ(kInterpolationModel, type);
+  ASSERT_LE(adaptive_stats.probes, slr_stats.probes);
+
+  // Dense bursts separated by large gaps need the segments of an SLR model.
+  Random rnd(301);
+  keys.clear();
+  uint64_t key = 0;
+  for (int i = 0; i < 3000; i++) {
+    key += 1 + (rnd.OneIn(50) ? rnd.Uniform(1 << 30) : rnd.Uniform(4));
+    keys.push_back(BigEndianKey(key, 8));
+  }
+  CheckSeekEveryKey(options, keys, nullptr, &type);
+  ASSERT_EQ(kSLRModel, type);
+
+  // Keys the projection cannot tell apart are left to binary search.
+  keys.clear();
+  for (uint64_t i = 0; i < 2000; i++) {
+    keys.push_back(BigEndianKey(i, 8));
+  }
+  delete projection;
+  projection = NewFixedWidthKeyProjection(1);
+  options.key_projection = projection;
+  CheckSeekEveryKey(options, keys, nullptr, &type);
+  ASSERT_EQ(0, type);
+  delete projection;
+}
+
+TEST(BlockSearchModeTest, RadixSplineSearch) {
+  const KeyProjection* projection = NewFixedWidthKeyProjection(8);
+  Options options;
+  options.key_projection = projection;
+
+  // Dense bursts separated by large gaps, like the Twitter user ids
+  Random rnd(301);
+  std::vector<std::string> keys;
+  uint64_t key = uint64_t{1} << 40;
+  for (int i = 0; i < 3000; i++) {
+    key += 1 + (rnd.OneIn(50) ? rnd.Uniform(1 << 30) : rnd.Uniform(4));
+    keys.push_back(BigEndianKey(key, 8));
+  }
+  for (int epsilon : {0, 1, 4, 64}) {
+    BlockSearchStats binary_stats, spline_stats;
+    int type;
+    options.block_restart_interval = 1 + epsilon % 3;
+    options.block_search_mode = kBinarySearch;
+    CheckSeekEveryKey(options, keys, &binary_stats);
+    options.block_search_mode = kRadixSplineSearch;
+    options.block_search_epsilon = epsilon;
+    CheckSeekEveryKey(options, keys, &spline_stats, &type);
+    ASSERT_EQ(kRadixSplineModel, type);
+    if (epsilon <= 4) {
+      ASSERT_LT(spline_stats.probes, binary_stats.probes) << epsilon;
+    }
+  }
+
+  // Keys over the whole 64-bit ordinal space, including both ends
+  keys.clear();
+  const uint64_t kStep = ~static_cast<uint64_t>(0) / 1999;
+  for (uint64_t i = 0; i < 2000; i++) {
+    keys.push_back(BigEndianKey(i * kStep + (i % 3), 8));
+  }
+  keys.push_back(BigEndianKey(~static_cast<uint64_t>(0), 8));
+  options.block_search_epsilon = 4;
+  options.block_restart_interval = 16;
+  CheckSeekEveryKey(options, keys);
+  delete projection;
+
+  // Keys the projection cannot tell apart still find every key
+  keys.clear();
+  for (uint64_t i = 0; i < 2000; i++) {
+    keys.push_back(BigEndianKey(i, 8));
+  }
+  projection = NewFixedWidthKeyProjection(1);
+  options.key_projection = projection;
+  options.block_restart_interval = 1;
+  const std::string data = BuildBlock(options, keys);
+  Block block(UnownedContents(data));
+  Iterator* iter = block.NewIterator(options.comparator, projection);
+  for (size_t i = 0; i < keys.size(); i++) {
+    iter->Seek(keys[i]);
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(keys[i], iter->key().ToString());
+  }
+  delete iter;
+  delete projection;
+}
+
+TEST(BlockSearchModeTest, UnknownModelType) {
+  // Blocks with a model from a newer release stay readable.
+  std::vector<std::string> keys;
+  for (int i = 0; i < 2000; i++) {
+    keys.push_back(DecimalKey(i * 3));
+  }
+  const KeyProjection* projection = NewDecimalKeyProjection();
+  Options options;
+  options.block_search_mode = kSLRSearch;
+  options.key_projection = projection;
+  std::string data = BuildBlock(options, keys);
+  ASSERT_EQ(kSLRModel, data[data.size() - 5]);
+  data[data.size() - 5] = 0x7f;
+
+  Block block(UnownedContents(data));
+  BlockSearchStats stats;
+  Iterator* iter = block.NewIterator(options.comparator, projection, &stats);
+  for (size_t i = 0; i < keys.size(); i++) {
+    iter->Seek(keys[i]);
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(keys[i], iter->key().ToString());
+  }
+  ASSERT_TRUE(iter->status().ok());
+  delete iter;
+  delete projection;
+}
+
+TEST(BlockSearchModeTest, MispredictedKeys) {
+  // Reading with a different projection than the block was built with
+  // sends every prediction to the wrong place; seeks must still succeed.
+  std::vector<std::string> keys;
+  for (uint64_t i = 0; i < 2000; i++) {
+    keys.push_back(BigEndianKey(i * i * i, 8));
+  }
+  const KeyProjection* projection = NewFixedWidthKeyProjection(8);
+  Options options;
+  options.block_search_mode = kSLRSearch;
+  options.key_projection = projection;
+  options.block_search_epsilon = 0;
+  const std::string data = BuildBlock(options, keys);
+  Block block(UnownedContents(data));
+
+  const KeyProjection* wrong = NewFixedWidthKeyProjection(1);
+  BlockSearchStats stats;
+  Iterator* iter = block.NewIterator(options.comparator, wrong, &stats);
+  // Backwards, so that no seek starts from the key before it
+  for (size_t i = keys.size() - 1; i >= 7; i -= 7) {
+    iter->Seek(keys[i]);
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(keys[i], iter->key().ToString());
+  }
+  delete iter;
+  ASSERT_GT(stats.fallbacks, 0);
+  delete wrong;
+  delete projection;
+}
+
+TEST(BlockSearchModeTest, MonotoneSeeks) {
+  std::vector<std::string> keys;
+  for (int i = 0; i < 4000; i++) {
+    keys.push_back(DecimalKey(1000 + i * 7 + (i % 5)));
+  }
+  const KeyProjection* projection = NewDecimalKeyProjection();
+  Options options;
+  options.key_projection = projection;
+  for (BlockSearchMode mode : {kSLRSearch, kRadixSplineSearch}) {
+    options.block_search_mode = mode;
+    const std::string data = BuildBlock(options, keys);
+    Block block(UnownedContents(data));
+
+    // Short forward steps, with an occasional step back, from one iterator
+    // and from a fresh one each time
+    Random rnd(301);
+    std::vector<std::string> targets;
+    size_t i = 0;
+    while (i < keys.size()) {
+      targets.push_back(rnd.OneIn(2) ? keys[i] : keys[i] + '\0');
+      i = rnd.OneIn(50) ? i / 2 : i + rnd.Uniform(40);
+    }
+    BlockSearchStats monotone, fresh;
+    Iterator* iter = block.NewIterator(options.comparator, projection,
+                                       &monotone);
+    for (const std::string& target : targets) {
+      const size_t expected =
+          std::lower_bound(keys.begin(), keys.end(), target) - keys.begin();
+      iter->Seek(target);
+      Iterator* fresh_iter =
+          block.NewIterator(options.comparator, projection, &fresh);
+      fresh_iter->Seek(target);
+      if (expected == keys.size()) {
+        ASSERT_TRUE(!iter->Valid());
+        ASSERT_TRUE(!fresh_iter->Valid());
+      } else {
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(keys[expected], iter->key().ToString());
+        ASSERT_EQ(keys[expected], fresh_iter->key().ToString());
+      }
+      delete fresh_iter;
+    }
+    delete iter;
+    ASSERT_LT(monotone.probes, fresh.probes) << mode;
+  }
+  delete projection;
+}
+
+TEST(BlockSearchModeTest, RunOffsetPrediction) {
+  std::vector<std::string> keys;
+  for (int i = 0; i < 4000; i++) {
+    keys.push_back(DecimalKey(1000 + i * 7 + (i % 5)));
+  }
+  const KeyProjection* projection = NewDecimalKeyProjection();
+  Options options;
+  options.key_projection = projection;
+  options.block_restart_interval = 32;
+  BlockSearchStats binary_stats, slr_stats;
+  options.block_search_mode = kBinarySearch;
+  CheckSeekEveryKey(options, keys, &binary_stats);
+  ASSERT_EQ(0, binary_stats.skipped);
+  options.block_search_mode = kSLRSearch;
+  CheckSeekEveryKey(options, keys, &slr_stats);
+  // Most entries before the target are passed without a compare
+  ASSERT_GT(slr_stats.skipped, slr_stats.seeks * 8);
+  ASSERT_LT(slr_stats.rescans, slr_stats.seeks / 20);
+
+  // Keys the restart keys place badly are still all found
+  Random rnd(301);
+  keys.clear();
+  uint64_t key = 0;
+  for (int i = 0; i < 4000; i++) {
+    key += 1 + (rnd.OneIn(10) ? rnd.Uniform(1 << 20) : rnd.Uniform(4));
+    keys.push_back(DecimalKey(key));
+  }
+  for (BlockSearchMode mode :
+       {kSLRSearch, kAdaptiveSearch, kRadixSplineSearch}) {
+    BlockSearchStats stats;
+    options.block_search_mode = mode;
+    CheckSeekEveryKey(options, keys, &stats);
+    ASSERT_GT(stats.rescans, 0);
+  }
+  delete projection;
+}
+
+TEST(BlockSearchModeTest, LongRestartRuns) {
+  std::vector<std::string> keys;
+  for (int i = 0; i < 1000; i++) {
+    keys.push_back(DecimalKey(1000 + i * 7 + (i % 5)));
+  }
+  const KeyProjection* projection = NewDecimalKeyProjection();
+  Options options;
+  options.key_projection = projection;
+  for (int interval : {64, 128}) {
+    // A handful of restart points still gets a model for the long runs
+    options.block_restart_interval = interval;
+    for (BlockSearchMode mode :
+         {kSLRSearch, kAdaptiveSearch, kRadixSplineSearch}) {
+      BlockSearchStats stats;
+      int type;
+      options.block_search_mode = mode;
+      CheckSeekEveryKey(options, keys, &stats, &type);
+      ASSERT_NE(0, type) << interval << " " << mode;
+      ASSERT_GT(stats.skipped, stats.seeks * interval / 4)
+          << interval << " " << mode;
+    }
+  }
+  delete projection;
+}
+
+TEST(BlockSearchModeTest, ReverseScan) {
+  std::vector<std::string> keys;
+  for (int i = 0; i < 3000; i++) {
+    keys.push_back(DecimalKey(1000 + i * 7 + (i % 5)));
+  }
+  const KeyProjection* projection = NewDecimalKeyProjection();
+  Options options;
+  options.key_projection = projection;
+  options.block_search_mode = kSLRSearch;
+  for (int interval : {1, 16, 128}) {
+    options.block_restart_interval = interval;
+    const std::string data = BuildBlock(options, keys);
+    Block block(UnownedContents(data));
+    Iterator* iter = block.NewIterator(options.comparator, projection);
+
+    iter->SeekToLast();
+    for (size_t i = keys.size(); i > 0; i--, iter->Prev()) {
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(keys[i - 1], iter->key().ToString());
+      ASSERT_EQ("v" + keys[i - 1], iter->value().ToString());
+    }
+    ASSERT_TRUE(!iter->Valid());
+
+    // Steps back interleaved with seeks and steps forward
+    Random rnd(301);
+    for (int n = 0; n < 200; n++) {
+      size_t i = rnd.Uniform(keys.size());
+      iter->Seek(keys[i]);
+      for (int step = 0; step < 300; step++) {
+        if (rnd.OneIn(4) && i + 1 < keys.size()) {
+          iter->Next();
+          i++;
+        } else if (i > 0) {
+          iter->Prev();
+          i--;
+        }
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(keys[i], iter->key().ToString());
+        ASSERT_EQ("v" + keys[i], iter->value().ToString());
+      }
+    }
+    ASSERT_LEVELDB_OK(iter->status());
+    delete iter;
+  }
+  delete projection;
+}
+
+TEST(BlockSearchModeTest, FixedWidthBlocks) {
+  Comparator* comparator = NewFixedWidthBytewiseComparator(8);
+  const KeyProjection* projection = NewFixedWidthKeyProjection(8);
+  Random rnd(301);
+  std::vector<std::string> keys;
+  uint64_t key = uint64_t{1} << 40;
+  for (int i = 0; i < 3000; i++) {
+    key += 1 + (rnd.OneIn(50) ? rnd.Uniform(1 << 30) : rnd.Uniform(4));
+    keys.push_back(BigEndianKey(key, 8));
+  }
+
+  Options options;
+  options.comparator = comparator;
+  options.key_projection = projection;
+  options.fixed_width_blocks = true;
+  options.block_search_epsilon = 4;
+  const BlockSearchMode kModes[] = {kBinarySearch, kSLRSearch,
+                                    kAdaptiveSearch, kRadixSplineSearch};
+  BlockSearchStats stats[4];
+  for (int i = 0; i < 4; i++) {
+    options.block_search_mode = kModes[i];
+    CheckSeekEveryKey(options, keys, &stats[i]);
+    if (i > 0) {
+      // The model predicts the entry itself
+      ASSERT_LT(stats[i].probes, stats[0].probes) << kModes[i];
+    }
+  }
+
+  const std::string data = BuildBlock(options, keys);
+  ASSERT_NE(0, DecodeFixed32(data.data() + data.size() - 4) &
+                   kBlockFixedWidthFlag);
+  Block block(UnownedContents(data));
+  Iterator* iter = block.NewIterator(comparator, projection);
+  iter->SeekToFirst();
+  for (size_t i = 0; i < keys.size(); i++, iter->Next()) {
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(keys[i], iter->key().ToString());
+    ASSERT_EQ("v" + keys[i], iter->value().ToString());
+  }
+  ASSERT_TRUE(!iter->Valid());
+  iter->SeekToLast();
+  for (size_t i = keys.size(); i > 0; i--, iter->Prev()) {
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(keys[i - 1], iter->key().ToString());
+    ASSERT_EQ("v" + keys[i - 1], iter->value().ToString());
+  }
+  ASSERT_TRUE(!iter->Valid());
+  iter->Seek(std::string(8, '\0'));
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(keys.front(), iter->key().ToString());
+  ASSERT_LEVELDB_OK(iter->status());
+  delete iter;
+
+  // Without the option the same comparator builds the usual format.
+  options.fixed_width_blocks = false;
+  const std::string prefix_data = BuildBlock(options, {keys[0]});
+  ASSERT_EQ(0, DecodeFixed32(prefix_data.data() + prefix_data.size() - 4) &
+                   kBlockFixedWidthFlag);
+  delete projection;
+  delete comparator;
+}
+
+TEST(BlockSearchModeTest, FixedWidthMismatchedKey) {
+  // A key of another width than the comparator promised turns the block
+  // into one of the usual format, holding every key.
+  Comparator* comparator = NewFixedWidthBytewiseComparator(8);
+  const KeyProjection* projection = NewFixedWidthKeyProjection(8);
+  std::vector<std::string> keys;
+  for (uint64_t i = 0; i < 1000; i++) {
+    keys.push_back(BigEndianKey(1000 + 7 * i, 8));
+    if (i == 500) {
+      keys.push_back(keys.back() + "x");
+    }
+  }
+  Options options;
+  options.comparator = comparator;
+  options.key_projection = projection;
+  options.fixed_width_blocks = true;
+  for (BlockSearchMode mode : {kBinarySearch, kSLRSearch}) {
+    options.block_search_mode = mode;
+    CheckSeekEveryKey(options, keys);
+    const std::string data = BuildBlock(options, keys);
+    ASSERT_EQ(0, DecodeFixed32(data.data() + data.size() - 4) &
+                     kBlockFixedWidthFlag);
+  }
+  delete projection;
+  delete comparator;
+}
+
+TEST(BlockSearchModeTest, FixedWidthDB) {
+  std::string dbname = testing::TempDir() + "fixed_width_block_testdb";
+  Comparator* comparator = NewFixedWidthBytewiseComparator(8);
+  Options options;
+  options.create_if_missing = true;
+  options.comparator = comparator;
+  options.fixed_width_blocks = true;
+  options.block_size = 32 * 1024;  // Big enough for data blocks to get a model
+  options.block_search_mode = kSLRSearch;
+  options.key_projection = NewFixedWidthKeyProjection(8);
+  ASSERT_LEVELDB_OK(DestroyDB(dbname, options));
+
+  DB* db;
+  ASSERT_LEVELDB_OK(DB::Open(options, dbname, &db));
+  for (uint64_t i = 0; i < 20000; i += 2) {
+    ASSERT_LEVELDB_OK(db->Put(WriteOptions(), BigEndianKey(i * i, 8),
+                              BigEndianKey(i, 8)));
+  }
+  db->CompactRange(nullptr, nullptr);
+  std::string value;
+  for (uint64_t i = 0; i < 20000; i++) {
+    Status s = db->Get(ReadOptions(), BigEndianKey(i * i, 8), &value);
+    if (i % 2 == 0) {
+      ASSERT_LEVELDB_OK(s);
+      ASSERT_EQ(BigEndianKey(i, 8), value);
+    } else {
+      ASSERT_TRUE(s.IsNotFound());
+    }
+  }
+  Iterator* iter = db->NewIterator(ReadOptions());
+  uint64_t i = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next(), i += 2) {
+    ASSERT_EQ(BigEndianKey(i * i, 8), iter->key().ToString());
+  }
+  ASSERT_EQ(20000, i);
+  ASSERT_LEVELDB_OK(iter->status());
+  delete iter;
+  delete db;
+  ASSERT_LEVELDB_OK(DestroyDB(dbname, options));
+  delete options.key_projection;
+  delete comparator;
+}
+
+// Builds a table of 5000 keys in "mode" and checks that its learned index
+// is a meta block named "model_name" holding a model of type "model_type"
+// over every index entry, and that the table is searched correctly with
+// and without it.
+static void CheckTableLearnedIndex(BlockSearchMode mode, const char* model_name,
+                                   BlockModelType model_type) {
+  const KeyProjection* projection = NewDecimalKeyProjection();
+  Options options;
+  options.block_size = 256;  // Many data blocks
+  options.block_search_mode = mode;
+  options.key_projection = projection;
+  StringSink sink;
+  TableBuilder builder(options, &sink);
+  std::vector<std::string> keys;
+  for (int i = 0; i < 5000; i++) {
+    keys.push_back(DecimalKey(3 * i + i % 3));
+    builder.Add(keys.back(), "v" + keys.back());
+  }
+  ASSERT_LEVELDB_OK(builder.Finish());
+  const std::string& file = sink.contents();
+  StringSource source(file);
+
+  // The index block is left without a model of its own ...
+  Slice footer_input(file.data() + file.size() - Footer::kEncodedLength,
+                     Footer::kEncodedLength);
+  Footer footer;
+  ASSERT_LEVELDB_OK(footer.DecodeFrom(&footer_input));
+  BlockContents contents;
+  ASSERT_LEVELDB_OK(
+      ReadBlock(&source, ReadOptions(), footer.index_handle(), &contents));
+  const uint32_t num_blocks =
+      DecodeFixed32(contents.data.data() + contents.data.size() - 4);
+  ASSERT_GT(num_blocks, 100);
+  ASSERT_LT(num_blocks, kBlockModelFlag);
+  delete[] contents.data.data();
+
+  // ... and the metaindex points at a model over all of its entries.
+  ASSERT_LEVELDB_OK(
+      ReadBlock(&source, ReadOptions(), footer.metaindex_handle(), &contents));
+  Block metaindex(contents);
+  Iterator* iter = metaindex.NewIterator(BytewiseComparator());
+  iter->SeekToFirst();
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(model_name, iter->key().ToString());
+  Slice handle_value = iter->value();
+  BlockHandle handle;
+  ASSERT_LEVELDB_OK(handle.DecodeFrom(&handle_value));
+  iter->Next();
+  ASSERT_TRUE(!iter->Valid());
+  delete iter;
+  ASSERT_LEVELDB_OK(ReadBlock(&source, ReadOptions(), handle, &contents));
+  if (model_type == kSLRModel) {
+    std::vector<LinearSegment> segments;
+    ASSERT_TRUE(DecodeSLRModel(contents.data, num_blocks, &segments));
+  } else {
+    std::vector<SplinePoint> knots;
+    int radix_bits;
+    uint32_t max_error;
+    ASSERT_TRUE(DecodeRadixSplineModel(contents.data, num_blocks, &knots,
+                                       &radix_bits, &max_error));
+    ASSERT_EQ(num_blocks - 1, knots.back().position);
+  }
+  delete[] contents.data.data();
+
+  // Tables are searched correctly with and without the learned index.
+  const KeyProjection* const kReadProjections[] = {projection, nullptr};
+  for (const KeyProjection* read_projection : kReadProjections) {
+    Options read_options;
+    read_options.key_projection = read_projection;
+    Table* table;
+    ASSERT_LEVELDB_OK(Table::Open(read_options, &source, file.size(), &table));
+    BlockSearchStats before;
+    GetBlockSearchStats(&before);
+    iter = table->NewIterator(ReadOptions());
+    for (size_t i = 0; i < keys.size(); i++) {
+      iter->Seek(keys[i]);
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(keys[i], iter->key().ToString());
+      ASSERT_EQ("v" + keys[i], iter->value().ToString());
+      iter->Seek(keys[i] + '\0');
+      if (i + 1 < keys.size()) {
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(keys[i + 1], iter->key().ToString());
+      } else {
+        ASSERT_TRUE(!iter->Valid());
+      }
+    }
+    ASSERT_LEVELDB_OK(iter->status());
+    delete iter;
+    // The index block's runs of one entry are never skipped into.
+    BlockSearchStats after;
+    GetBlockSearchStats(&after);
+    ASSERT_GE(after.seeks - before.seeks, 2 * keys.size());
+    ASSERT_EQ(before.skipped, after.skipped);
+    ASSERT_EQ(before.rescans, after.rescans);
+    delete table;
+  }
+  delete projection;
+}
+
+TEST(BlockSearchModeTest, TableLearnedIndex) {
+  CheckTableLearnedIndex(kSLRSearch, kIndexModelName, kSLRModel);
+  CheckTableLearnedIndex(kRadixSplineSearch, kIndexSplineName,
+                         kRadixSplineModel);
+}
+
+// Builds a table of "keys" with "options", checks that every key is found
+// in it, and stores the model errors recorded for its data blocks in
+// *stats.
+static void BuildTableModelStats(const Options& options,
+                                 const std::vector<std::string>& keys,
+                                 TableModelStats* stats) {
+  StringSink sink;
+  TableBuilder builder(options, &sink);
+  for (const std::string& key : keys) {
+    builder.Add(key, "v" + key);
+  }
+  ASSERT_LEVELDB_OK(builder.Finish());
+  StringSource source(sink.contents());
+  Table* table;
+  ASSERT_LEVELDB_OK(
+      Table::Open(options, &source, sink.contents().size(), &table));
+  ASSERT_TRUE(table->GetModelStats(stats));
+  Iterator* iter = table->NewIterator(ReadOptions());
+  for (const std::string& key : keys) {
+    iter->Seek(key);
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(key, iter->key().ToString());
+  }
+  ASSERT_LEVELDB_OK(iter->status());
+  delete iter;
+  delete table;
+}
+
+TEST(BlockSearchModeTest, ModelBlockBoundaries) {
+  // Clusters of closely spaced keys far apart from each other
+  Random rnd(301);
+  std::vector<std::string> keys;
+  int key = 0;
+  while (keys.size() < 20000) {
+    key += 100000;
+    const int cluster = 20 + rnd.Uniform(200);
+    for (int i = 0; i < cluster; i++) {
+      key += 1 + rnd.Uniform(5);
+      keys.push_back(DecimalKey(key));
+    }
+  }
+  const KeyProjection* projection = NewDecimalKeyProjection();
+  Options options;
+  options.key_projection = projection;
+  options.block_restart_interval = 2;
+  for (BlockSearchMode mode : {kSLRSearch, kRadixSplineSearch}) {
+    options.block_search_mode = mode;
+    options.model_block_boundaries = false;
+    TableModelStats plain;
+    BuildTableModelStats(options, keys, &plain);
+    options.model_block_boundaries = true;
+    TableModelStats aligned;
+    BuildTableModelStats(options, keys, &aligned);
+
+    uint64_t counted = 0;
+    for (int i = 0; i < kModelErrorBuckets; i++) {
+      counted += aligned.histogram[i];
+    }
+    ASSERT_EQ(aligned.keys, counted);
+    ASSERT_EQ(0, plain.early_cuts + plain.grown_blocks);
+    ASSERT_GT(aligned.early_cuts + aligned.grown_blocks, aligned.blocks / 4);
+    // About the same number of blocks, with fewer breaks inside them
+    ASSERT_LT(aligned.blocks, plain.blocks * 11 / 10) << mode;
+    ASSERT_GT(aligned.blocks, plain.blocks * 9 / 10) << mode;
+    ASSERT_LT(aligned.segments, plain.segments) << mode;
+  }
+  delete projection;
+}
+
+TEST(BlockSearchModeTest, MixedModeDB) {
+  std::string dbname = testing::TempDir() + "block_search_mode_testdb";
+  Options options;
+  options.create_if_missing = true;
+  options.block_size = 32 * 1024;  // Big enough for data blocks to get a model
+  options.block_search_mode = kSLRSearch;
+  options.key_projection = NewDecimalKeyProjection();
+  ASSERT_LEVELDB_OK(DestroyDB(dbname, options));
+
+  DB* db;
+  ASSERT_LEVELDB_OK(DB::Open(options, dbname, &db));
+  for (int i = 0; i < 10000; i += 2) {
+    ASSERT_LEVELDB_OK(db->Put(WriteOptions(), DecimalKey(i), DecimalKey(i)));
+  }
+  db->CompactRange(nullptr, nullptr);
+  delete db;
+
+  // Reopen in binary mode; old SLR tables stay readable while new and
+  // compacted tables are written without a model.
+  options.block_search_mode = kBinarySearch;
+  ASSERT_LEVELDB_OK(DB::Open(options, dbname, &db));
+  for (int i = 1; i < 10000; i += 2) {
+    ASSERT_LEVELDB_OK(db->Put(WriteOptions(), DecimalKey(i), DecimalKey(i)));
+  }
+  for (int pass = 0; pass < 2; pass++) {
+    std::string value;
+    for (int i = 0; i < 10000; i++) {
+      ASSERT_LEVELDB_OK(db->Get(ReadOptions(), DecimalKey(i), &value));
+      ASSERT_EQ(DecimalKey(i), value);
+    }
+    db->CompactRange(nullptr, nullptr);
+  }
+  delete db;
+  ASSERT_LEVELDB_OK(DestroyDB(dbname, options));
+  delete options.key_projection;
+}
+
 TEST(MemTableTest, Simple) {
   InternalKeyComparator cmp(BytewiseComparator());
   MemTable* memtable = new MemTable(cmp);
@@ -745,6 +1673,82 @@ TEST(MemTableTest, Simple) {
   memtable->Unref();
 }
 
+TEST(MemTableTest, Frozen) {
+  const KeyProjection* user_projection = NewDecimalKeyProjection();
+  InternalKeyProjection projection(user_projection);
+  InternalKeyComparator cmp(BytewiseComparator());
+  Random rnd(301);
+  for (bool use_model : {false, true}) {
+    MemTable* memtable = new MemTable(cmp);
+    memtable->Ref();
+    // Several versions of some keys, and some deleted
+    std::vector<std::string> keys;
+    SequenceNumber seq = 1;
+    for (int i = 0; i < 3000; i++) {
+      keys.push_back(DecimalKey(1000 + i * 10 + rnd.Uniform(5)));
+      for (int v = rnd.Uniform(3); v >= 0; v--) {
+        memtable->Add(seq, rnd.OneIn(5) ? kTypeDeletion : kTypeValue,
+                      keys.back(), "v" + std::to_string(seq));
+        seq++;
+      }
+    }
+
+    // Every lookup, at every snapshot, and every scan gives the same
+    // results once frozen.
+    std::vector<std::string> results;
+    std::vector<std::string> probes = {DecimalKey(0), DecimalKey(999999999)};
+    for (const std::string& key : keys) {
+      probes.push_back(key);
+      probes.push_back(DecimalKey(std::stoi(key) + 1));
+    }
+    for (int pass = 0; pass < 2; pass++) {
+      if (pass == 1) {
+        memtable->Freeze(use_model ? &projection : nullptr, 4);
+        ASSERT_TRUE(memtable->frozen());
+      }
+      size_t r = 0;
+      for (const std::string& probe : probes) {
+        for (SequenceNumber snapshot : {seq / 3, seq / 2, seq}) {
+          std::string value;
+          Status s;
+          std::string result = "none";
+          if (memtable->Get(LookupKey(probe, snapshot), &value, &s)) {
+            result = s.ok() ? value : "deleted";
+          }
+          if (pass == 0) {
+            results.push_back(result);
+          } else {
+            ASSERT_EQ(results[r++], result) << probe << " @ " << snapshot;
+          }
+        }
+      }
+      std::string scan;
+      Iterator* iter = memtable->NewIterator();
+      for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        scan += iter->key().ToString() + iter->value().ToString();
+      }
+      for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+        scan += iter->key().ToString();
+      }
+      Random seek_rnd(17);
+      for (int i = 0; i < 100; i++) {
+        iter->Seek(InternalKey(probes[seek_rnd.Uniform(probes.size())],
+                               kMaxSequenceNumber, kValueTypeForSeek)
+                       .Encode());
+        scan += iter->Valid() ? iter->key().ToString() : "end";
+      }
+      delete iter;
+      if (pass == 0) {
+        results.push_back(scan);
+      } else {
+        ASSERT_EQ(results.back(), scan);
+      }
+    }
+    memtable->Unref();
+  }
+  delete user_projection;
+}
+
 static bool Between(uint64_t val, uint64_t low, uint64_t high) {
   bool result = (val >= low) && (val <= high);
   if (!result) {
@@ -65,6 +65,16 @@ class BytewiseComparatorImpl : public Comparator {
     // *key is a run of 0xffs.  Leave it alone.
   }
 };
+
+class FixedWidthBytewiseComparator : public BytewiseComparatorImpl {
+ public:
+  explicit FixedWidthBytewiseComparator(size_t width) : width_(width) {}
+
+  size_t FixedKeyWidth() const override { return width_; }
+
+ private:
+  const size_t width_;
+};
 }  // namespace
 
 const Comparator* BytewiseComparator() {
@@ -72,4 +82,9 @@ const Comparator* BytewiseComparator() {
   return singleton.get();
 }
 
+Comparator* NewFixedWidthBytewiseComparator(size_t width) {
+  assert(width > 0);
+  return new FixedWidthBytewiseComparator(width);
+}
+
 }  // namespace leveldb
@@ -0,0 +1,87 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/key_projection.h"
+
+#include <cassert>
+
+#include "leveldb/slice.h"
+
+namespace leveldb {
+
+KeyProjection::~KeyProjection() = default;
+
+namespace {
+
+// Big-endian value of the first "width" bytes of "key", zero padded.
+inline uint64_t BigEndianPrefix(const Slice& key, size_t width) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(key.data());
+  const size_t n = key.size() < width ? key.size() : width;
+  uint64_t result = 0;
+  size_t i = 0;
+  for (; i < n; i++) {
+    result = (result << 8) | p[i];
+  }
+  for (; i < width; i++) {
+    result <<= 8;
+  }
+  return result;
+}
+
+class DecimalKeyProjection : public KeyProjection {
+ public:
+  const char* Name() const override { return "leveldb.DecimalKeyProjection"; }
+
+  uint64_t ToOrdinal(const Slice& key) const override {
+    static const uint64_t kMaxUint64 = ~static_cast<uint64_t>(0);
+    uint64_t result = 0;
+    for (size_t i = 0; i < key.size(); i++) {
+      const char c = key[i];
+      if (c < '0' || c > '9') {
+        break;
+      }
+      const uint64_t delta = c - '0';
+      if (result > kMaxUint64 / 10 ||
+          (result == kMaxUint64 / 10 && delta > kMaxUint64 % 10)) {
+        return kMaxUint64;
+      }
+      result = result * 10 + delta;
+    }
+    return result;
+  }
+};
+
+class FixedWidthKeyProjection : public KeyProjection {
+ public:
+  explicit FixedWidthKeyProjection(size_t width) : width_(width) {
+    assert(width_ >= 1 && width_ <= 8);
+  }
+
+  const char* Name() const override {
+    return "leveldb.FixedWidthKeyProjection";
+  }
+
+  uint64_t ToOrdinal(const Slice& key) const override {
+    return BigEndianPrefix(key, width_);
+  }
+
+ private:
+  const size_t width_;
+};
+
+}  // namespace
+
+const KeyProjection* NewDecimalKeyProjection() {
+  return new DecimalKeyProjection;
+}
+
+const KeyProjection* NewFixedWidthKeyProjection(size_t width) {
+  return new FixedWidthKeyProjection(width);
+}
+
+const KeyProjection* NewPrefixKeyProjection() {
+  return new FixedWidthKeyProjection(8);
+}
+
+}  // namespace leveldb
@@ -0,0 +1,60 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/key_projection.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "leveldb/slice.h"
+#include "util/random.h"
+#include "util/testutil.h"
+
+namespace leveldb {
+
+TEST(KeyProjectionTest, Decimal) {
+  const KeyProjection* p = NewDecimalKeyProjection();
+  ASSERT_EQ(0, p->ToOrdinal(""));
+  ASSERT_EQ(0, p->ToOrdinal("abc"));
+  ASSERT_EQ(340895854, p->ToOrdinal("340895854"));
+  ASSERT_EQ(42, p->ToOrdinal("000042"));
+  ASSERT_EQ(123, p->ToOrdinal(Slice("123\x01\x02", 5)));
+  ASSERT_EQ(18446744073709551615ull, p->ToOrdinal("18446744073709551615"));
+  ASSERT_EQ(~0ull, p->ToOrdinal("18446744073709551616"));
+  ASSERT_EQ(~0ull, p->ToOrdinal("99999999999999999999999"));
+  delete p;
+}
+
+TEST(KeyProjectionTest, FixedWidth) {
+  const KeyProjection* p = NewFixedWidthKeyProjection(4);
+  ASSERT_EQ(0x01020304, p->ToOrdinal("\x01\x02\x03\x04"));
+  ASSERT_EQ(0x01020304, p->ToOrdinal("\x01\x02\x03\x04rest"));
+  ASSERT_EQ(0x01020000, p->ToOrdinal("\x01\x02"));
+  delete p;
+
+  p = NewFixedWidthKeyProjection(8);
+  ASSERT_EQ(0xfffefdfcfbfaf9f8ull,
+            p->ToOrdinal("\xff\xfe\xfd\xfc\xfb\xfa\xf9\xf8"));
+  delete p;
+}
+
+TEST(KeyProjectionTest, PrefixIsMonotone) {
+  const KeyProjection* p = NewPrefixKeyProjection();
+  ASSERT_EQ(0x6162630000000000ull, p->ToOrdinal("abc"));
+
+  Random rnd(301);
+  std::vector<std::string> keys;
+  for (int i = 0; i < 1000; i++) {
+    keys.push_back(test::RandomKey(&rnd, rnd.Uniform(12)));
+  }
+  std::sort(keys.begin(), keys.end());
+  for (size_t i = 1; i < keys.size(); i++) {
+    ASSERT_LE(p->ToOrdinal(keys[i - 1]), p->ToOrdinal(keys[i]));
+  }
+  delete p;
+}
+
+}  // namespace leveldb
@@ -0,0 +1,150 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "util/piecewise_linear.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <utility>
+
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+
+namespace leveldb {
+
+namespace {
+
+// Arrays up to this length are compared in full, which has no dependent
+// loads; longer ones are binary searched.
+constexpr size_t kFullScanLimit = 32;
+
+}  // namespace
+
+size_t CountKeysAtMost(const uint64_t* keys, size_t n, uint64_t key) {
+  if (n > kFullScanLimit) {
+    // The answer stays in [base - keys, base - keys + n]
+    const uint64_t* base = keys;
+    while (n > 1) {
+      const size_t half = n / 2;
+      base += (base[half] <= key) ? half : 0;
+      n -= half;
+    }
+    return (base - keys) + (*base <= key);
+  }
+
+  size_t count = 0;
+  size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE4_2__)
+  // SIMD compares are signed, so flip the sign bits to compare unsigned.
+  const uint64_t kSignBit = uint64_t{1} << 63;
+#endif
+#if defined(__AVX2__)
+  const __m256i sign = _mm256_set1_epi64x(static_cast<int64_t>(kSignBit));
+  const __m256i target =
+      _mm256_set1_epi64x(static_cast<int64_t>(key ^ kSignBit));
+  for (; i + 4 <= n; i += 4) {
+    const __m256i v = _mm256_xor_si256(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), sign);
+    // One bit per lane holding a key above the target
+    const int above =
+        _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(v, target)));
+    count += 4 - ((above & 1) + ((above >> 1) & 1) + ((above >> 2) & 1) +
+                  ((above >> 3) & 1));
+  }
+#elif defined(__SSE4_2__)
+  const __m128i sign = _mm_set1_epi64x(static_cast<int64_t>(kSignBit));
+  const __m128i target = _mm_set1_epi64x(static_cast<int64_t>(key ^ kSignBit));
+  for (; i + 2 <= n; i += 2) {
+    const __m128i v = _mm_xor_si128(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)), sign);
+    // One bit per lane holding a key above the target
+    const int above = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(v, target)));
+    count += 2 - ((above & 1) + ((above >> 1) & 1));
+  }
+#endif
+  for (; i < n; i++) {
+    count += (keys[i] <= key);
+  }
+  return count;
+}
+
+PiecewiseLinearModel::PiecewiseLinearModel(std::vector<LinearSegment> segments)
+    : segments_(std::move(segments)) {
+  first_keys_.reserve(segments_.size());
+  for (const LinearSegment& segment : segments_) {
+    first_keys_.push_back(segment.first_key);
+  }
+}
+
+PiecewiseLinearFitter::PiecewiseLinearFitter(uint32_t epsilon)
+    : epsilon_(epsilon),
+      open_start_(0),
+      min_slope_(0),
+      max_slope_(std::numeric_limits<double>::infinity()) {}
+
+void PiecewiseLinearFitter::Add(uint64_t key) {
+  assert(keys_.empty() || key >= keys_.back());
+  const uint32_t position = keys_.size();
+  keys_.push_back(key);
+  if (position == 0) {
+    return;
+  }
+
+  const uint64_t dx = key - keys_[open_start_];
+  const double dy = position - open_start_;
+  bool fits;
+  if (dx == 0) {
+    // Predicted at the start of the segment whatever the slope
+    fits = (dy <= epsilon_);
+  } else {
+    const double slope = dy / static_cast<double>(dx);
+    fits = (slope >= min_slope_ && slope <= max_slope_);
+  }
+
+  if (!fits) {
+    segments_.push_back(MakeSegment(open_start_, position - 1, true));
+    open_start_ = position;
+    min_slope_ = 0;
+    max_slope_ = std::numeric_limits<double>::infinity();
+  } else if (dx != 0) {
+    min_slope_ = std::max(min_slope_, (dy - epsilon_) / dx);
+    max_slope_ = std::min(max_slope_, (dy + epsilon_) / dx);
+  }
+}
+
+LinearSegment PiecewiseLinearFitter::OpenSegment() const {
+  assert(!keys_.empty());
+  return MakeSegment(open_start_, keys_.size() - 1, false);
+}
+
+void PiecewiseLinearFitter::Finish(std::vector<LinearSegment>* segments) const {
+  *segments = segments_;
+  if (!keys_.empty()) {
+    segments->push_back(MakeSegment(open_start_, keys_.size() - 1, true));
+  }
+}
+
+LinearSegment PiecewiseLinearFitter::MakeSegment(uint32_t first, uint32_t last,
+                                                 bool measure) const {
+  LinearSegment segment;
+  segment.first_key = keys_[first];
+  segment.key_span = keys_[last] - keys_[first];
+  segment.first_position = first;
+  segment.position_span = last - first;
+  segment.slope = SegmentSlope(segment.key_span, segment.position_span);
+  segment.max_error = epsilon_;
+  if (measure) {
+    segment.max_error = 0;
+    for (uint32_t p = first; p <= last; p++) {
+      const uint32_t predicted = PredictPosition(segment, keys_[p]);
+      const uint32_t error = predicted > p ? predicted - p : p - predicted;
+      segment.max_error = std::max(segment.max_error, error);
+    }
+  }
+  return segment;
+}
+
+}  // namespace leveldb
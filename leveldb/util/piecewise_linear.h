@@ -0,0 +1,158 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Error-bounded piecewise-linear models from sorted 64-bit keys to their
+// positions, used by learned search structures.
+
+#ifndef STORAGE_LEVELDB_UTIL_PIECEWISE_LINEAR_H_
+#define STORAGE_LEVELDB_UTIL_PIECEWISE_LINEAR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace leveldb {
+
+// One segment of a piecewise-linear model.  The segment covers positions
+// [first_position, first_position + position_span] and predicts them with
+// the line through its first and last (key, position) point.
+struct LinearSegment {
+  uint64_t first_key;
+  uint64_t key_span;  // Last key of the segment minus first_key
+  uint32_t first_position;
+  uint32_t position_span;  // Last position of the segment minus first_position
+  uint32_t max_error;      // Largest distance of a prediction from its position
+  double slope;            // position_span / key_span, see SegmentSlope()
+};
+
+// Returns the slope of a segment.  Readers and writers must both derive
+// it with this function so that they make the same predictions.
+inline double SegmentSlope(uint64_t key_span, uint32_t position_span) {
+  return key_span == 0 ? 0.0
+                       : position_span / static_cast<double>(key_span);
+}
+
+// Returns the position "segment" predicts for "key", rounded down and
+// clamped to the positions covered by the segment.  Inside the segment
+// this is a single multiply-add; the slope is in double precision so
+// that keys anywhere in the 64-bit space neither overflow nor truncate it.
+inline uint32_t PredictPosition(const LinearSegment& segment, uint64_t key) {
+  if (key <= segment.first_key) {
+    return segment.first_position;
+  }
+  const uint64_t delta = key - segment.first_key;
+  if (delta >= segment.key_span) {
+    return segment.first_position + segment.position_span;
+  }
+  return segment.first_position +
+         static_cast<uint32_t>(static_cast<double>(delta) * segment.slope);
+}
+
+// Returns the number of keys in the sorted array keys[0, n) that are <=
+// "key", which is the index of the first key above it.  Short arrays are
+// compared in full with SIMD when built for AVX2 or SSE4.2 (and with a
+// branchless scalar loop otherwise); longer ones are binary searched
+// without data-dependent branches.
+size_t CountKeysAtMost(const uint64_t* keys, size_t n, uint64_t key);
+
+// A piecewise-linear model ready for lookups.  The segments' first keys
+// are copied into a dense array of their own for the search that picks
+// the segment of a key.
+class PiecewiseLinearModel {
+ public:
+  // An empty model, which must not be used for predictions.
+  PiecewiseLinearModel() = default;
+
+  // REQUIRES: "segments" tile positions [0, n) in order of position
+  explicit PiecewiseLinearModel(std::vector<LinearSegment> segments);
+
+  bool empty() const { return segments_.empty(); }
+
+  const std::vector<LinearSegment>& segments() const { return segments_; }
+
+  // Returns the bytes of heap memory the model holds.
+  size_t ApproximateMemoryUsage() const {
+    return first_keys_.capacity() * sizeof(uint64_t) +
+           segments_.capacity() * sizeof(LinearSegment);
+  }
+
+  // Returns the position predicted for "key" by the last segment starting
+  // at or below it (or the first segment if there is none), and stores in
+  // *max_error how far that segment's predictions can be from a position.
+  // REQUIRES: !empty()
+  uint32_t Predict(uint64_t key, uint32_t* max_error) const {
+    size_t which_segment =
+        CountKeysAtMost(first_keys_.data(), first_keys_.size(), key);
+    if (which_segment > 0) {
+      which_segment--;
+    }
+    const LinearSegment& segment = segments_[which_segment];
+    *max_error = segment.max_error;
+    return PredictPosition(segment, key);
+  }
+
+ private:
+  std::vector<uint64_t> first_keys_;  // Segment directory
+  std::vector<LinearSegment> segments_;
+};
+
+// Greedily cuts a non-decreasing sequence of keys into segments such that
+// every key's position is predicted within "epsilon" of its true position.
+// Like ShrinkingCone, it keeps the cone of slopes through the first point
+// of the open segment that satisfy every point added so far, so Add() is
+// O(1); a segment is closed as soon as the line to the next point leaves
+// the cone.
+class PiecewiseLinearFitter {
+ public:
+  explicit PiecewiseLinearFitter(uint32_t epsilon);
+
+  // Append the key at the next position.
+  // REQUIRES: key >= every previously added key
+  void Add(uint64_t key);
+
+  // Number of keys added so far.
+  size_t num_keys() const { return keys_.size(); }
+
+  // The keys added so far, in order.
+  const std::vector<uint64_t>& keys() const { return keys_; }
+
+  // REQUIRES: num_keys() > 0
+  uint64_t last_key() const { return keys_.back(); }
+
+  // Number of segments Finish() would produce for the keys added so far.
+  size_t NumSegments() const {
+    return segments_.size() + (keys_.empty() ? 0 : 1);
+  }
+
+  // Segments that no later key can extend, with their measured max_error.
+  const std::vector<LinearSegment>& closed_segments() const {
+    return segments_;
+  }
+
+  // The segment the last key belongs to.  Its max_error is not measured
+  // but set to epsilon, which bounds it up to rounding.
+  // REQUIRES: num_keys() > 0
+  LinearSegment OpenSegment() const;
+
+  // Store the segments for the keys added so far in *segments, with the
+  // measured max_error of each.  Rounding can make a measured error exceed
+  // epsilon by one on keys beyond 2^53; it never understates the error.
+  void Finish(std::vector<LinearSegment>* segments) const;
+
+ private:
+  // Returns the segment covering positions [first, last], measuring its
+  // error iff "measure" is true.
+  LinearSegment MakeSegment(uint32_t first, uint32_t last, bool measure) const;
+
+  uint32_t epsilon_;
+  std::vector<uint64_t> keys_;
+  std::vector<LinearSegment> segments_;  // Closed segments
+  uint32_t open_start_;                  // First position of the open segment
+  double min_slope_;  // Cone of feasible slopes for the open segment
+  double max_slope_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_PIECEWISE_LINEAR_H_
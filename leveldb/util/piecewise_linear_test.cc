@@ -0,0 +1,156 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "util/piecewise_linear.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "util/random.h"
+
+namespace leveldb {
+
+// Fits "keys" and checks that the segments tile every position and
+// predict each one within the stored error, which is within epsilon.
+static std::vector<LinearSegment> Fit(const std::vector<uint64_t>& keys,
+                                      uint32_t epsilon) {
+  PiecewiseLinearFitter fitter(epsilon);
+  for (uint64_t key : keys) {
+    fitter.Add(key);
+  }
+  std::vector<LinearSegment> segments;
+  fitter.Finish(&segments);
+  EXPECT_EQ(fitter.NumSegments(), segments.size());
+  if (!keys.empty()) {
+    // Only the last segment is still open.
+    EXPECT_EQ(segments.size() - 1, fitter.closed_segments().size());
+    EXPECT_EQ(segments.back().first_position,
+              fitter.OpenSegment().first_position);
+    EXPECT_EQ(segments.back().key_span, fitter.OpenSegment().key_span);
+  }
+
+  uint32_t position = 0;
+  for (const LinearSegment& segment : segments) {
+    EXPECT_EQ(position, segment.first_position);
+    EXPECT_LE(segment.max_error, epsilon);
+    for (uint32_t i = 0; i <= segment.position_span; i++, position++) {
+      const uint32_t predicted = PredictPosition(segment, keys[position]);
+      const uint32_t error =
+          predicted > position ? predicted - position : position - predicted;
+      EXPECT_LE(error, segment.max_error);
+    }
+  }
+  EXPECT_EQ(keys.size(), position);
+  return segments;
+}
+
+TEST(PiecewiseLinearTest, Empty) {
+  PiecewiseLinearFitter fitter(4);
+  std::vector<LinearSegment> segments;
+  fitter.Finish(&segments);
+  ASSERT_EQ(0, fitter.NumSegments());
+  ASSERT_TRUE(segments.empty());
+}
+
+TEST(PiecewiseLinearTest, Linear) {
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 1000; i++) {
+    keys.push_back(1000000 + i * 37);
+  }
+  std::vector<LinearSegment> segments = Fit(keys, 0);
+  ASSERT_EQ(1, segments.size());
+  ASSERT_EQ(0, segments[0].max_error);
+  ASSERT_EQ(999, segments[0].position_span);
+}
+
+TEST(PiecewiseLinearTest, TwoSlopes) {
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 100; i++) {
+    keys.push_back(i * 2);
+  }
+  for (uint64_t i = 0; i < 100; i++) {
+    keys.push_back(1000 + i * 50);
+  }
+  ASSERT_EQ(2, Fit(keys, 0).size());
+  ASSERT_LE(Fit(keys, 2).size(), 3);
+}
+
+TEST(PiecewiseLinearTest, Duplicates) {
+  std::vector<uint64_t> keys = {5, 5, 5, 5, 9, 9, 12};
+  Fit(keys, 0);
+  ASSERT_EQ(1, Fit(keys, 8).size());
+}
+
+TEST(PiecewiseLinearTest, FullRange) {
+  std::vector<uint64_t> keys = {0, 1, 1ull << 40, 1ull << 62, ~0ull - 1,
+                                ~0ull};
+  Fit(keys, 0);
+  Fit(keys, 1);
+}
+
+TEST(PiecewiseLinearTest, Skewed) {
+  Random rnd(301);
+  std::vector<uint64_t> keys;
+  uint64_t key = 0;
+  for (int i = 0; i < 2000; i++) {
+    // Mostly dense runs broken up by occasional large gaps
+    key += rnd.OneIn(20) ? rnd.Uniform(1 << 30) : rnd.Uniform(8);
+    keys.push_back(key);
+  }
+  size_t last_count = keys.size() + 1;
+  for (uint32_t epsilon : {0, 1, 4, 16, 64}) {
+    const size_t count = Fit(keys, epsilon).size();
+    ASSERT_LT(count, last_count) << "epsilon " << epsilon;
+    last_count = count;
+  }
+}
+
+TEST(PiecewiseLinearTest, Model) {
+  Random rnd(301);
+  std::vector<uint64_t> keys;
+  uint64_t key = 0;
+  for (int i = 0; i < 2000; i++) {
+    key += 1 + (rnd.OneIn(20) ? rnd.Uniform(1 << 30) : rnd.Uniform(8));
+    keys.push_back(key);
+  }
+  const PiecewiseLinearModel model(Fit(keys, 4));
+  ASSERT_FALSE(model.empty());
+  for (uint32_t position = 0; position < keys.size(); position++) {
+    uint32_t max_error;
+    const uint32_t predicted = model.Predict(keys[position], &max_error);
+    ASSERT_LE(max_error, 4);
+    ASSERT_LE(predicted, position + max_error);
+    ASSERT_LE(position, predicted + max_error);
+  }
+}
+
+TEST(PiecewiseLinearTest, CountKeysAtMost) {
+  Random rnd(301);
+  for (size_t n = 0; n <= 100; n++) {
+    std::vector<uint64_t> keys;
+    for (size_t i = 0; i < n; i++) {
+      // Duplicates and keys on both sides of the sign bit
+      uint64_t key = rnd.Uniform(2 * n + 1);
+      if (rnd.OneIn(2)) key |= uint64_t{1} << 63;
+      keys.push_back(key);
+    }
+    std::sort(keys.begin(), keys.end());
+    std::vector<uint64_t> probes = {0, ~uint64_t{0}, uint64_t{1} << 63,
+                                    (uint64_t{1} << 63) - 1};
+    for (uint64_t key : keys) {
+      probes.push_back(key);
+      probes.push_back(key - 1);
+      probes.push_back(key + 1);
+    }
+    for (uint64_t probe : probes) {
+      const size_t expected =
+          std::upper_bound(keys.begin(), keys.end(), probe) - keys.begin();
+      ASSERT_EQ(expected, CountKeysAtMost(keys.data(), keys.size(), probe))
+          << "n " << n << " probe " << probe;
+    }
+  }
+}
+
+}  // namespace leveldb
@@ -0,0 +1,136 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "util/radix_spline.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <utility>
+
+namespace leveldb {
+
+uint32_t SplineError(const std::vector<SplinePoint>& points,
+                     const std::vector<uint64_t>& keys) {
+  uint32_t max_error = 0;
+  size_t next = 0;  // First knot with a key >= the current key
+  for (uint32_t i = 0; i < keys.size(); i++) {
+    const uint64_t key = keys[i];
+    while (next < points.size() && points[next].key < key) {
+      next++;
+    }
+    uint32_t predicted;
+    if (next == 0) {
+      predicted = points.front().position;
+    } else if (next == points.size()) {
+      predicted = points.back().position;
+    } else {
+      predicted = InterpolateSpline(points[next - 1], points[next], key);
+    }
+    const uint32_t error = predicted > i ? predicted - i : i - predicted;
+    max_error = std::max(max_error, error);
+  }
+  return max_error;
+}
+
+int RadixBitsFor(size_t num_points) {
+  int bits = 1;
+  while (bits < kMaxRadixBits && (size_t{1} << bits) < 2 * num_points) {
+    bits++;
+  }
+  return bits;
+}
+
+RadixSplineBuilder::RadixSplineBuilder(uint32_t epsilon)
+    : epsilon_(epsilon),
+      num_keys_(0),
+      last_{0, 0},
+      lower_slope_(-std::numeric_limits<double>::infinity()),
+      upper_slope_(std::numeric_limits<double>::infinity()) {}
+
+void RadixSplineBuilder::Add(uint64_t key) {
+  assert(num_keys_ == 0 || key >= last_.key);
+  const uint32_t position = num_keys_++;
+  if (position == 0) {
+    last_ = SplinePoint{key, 0};
+    knots_.push_back(last_);
+    return;
+  }
+  if (key == last_.key) {
+    return;
+  }
+
+  const SplinePoint point{key, position};
+  const SplinePoint& base = knots_.back();
+  const double slope = (point.position - base.position) /
+                       static_cast<double>(point.key - base.key);
+  if (slope < lower_slope_ || slope > upper_slope_) {
+    // The line to "point" leaves the corridor, so the spline bends at the
+    // previous key.
+    knots_.push_back(last_);
+    lower_slope_ = -std::numeric_limits<double>::infinity();
+    upper_slope_ = std::numeric_limits<double>::infinity();
+  }
+  Constrain(point);
+  last_ = point;
+}
+
+void RadixSplineBuilder::Constrain(const SplinePoint& point) {
+  const SplinePoint& base = knots_.back();
+  const double dx = static_cast<double>(point.key - base.key);
+  const double dy = static_cast<double>(point.position) - base.position;
+  lower_slope_ = std::max(lower_slope_, (dy - epsilon_) / dx);
+  upper_slope_ = std::min(upper_slope_, (dy + epsilon_) / dx);
+}
+
+void RadixSplineBuilder::Finish(std::vector<SplinePoint>* points) const {
+  *points = knots_;
+  if (!knots_.empty() && last_.key != knots_.back().key) {
+    points->push_back(last_);
+  }
+}
+
+RadixSplineModel::RadixSplineModel(std::vector<SplinePoint> points,
+                                   int radix_bits, uint32_t max_error)
+    : points_(std::move(points)), shift_(0), max_error_(max_error) {
+  assert(!points_.empty());
+  assert(radix_bits >= 1 && radix_bits <= kMaxRadixBits);
+  const uint64_t first = points_.front().key;
+  const uint64_t range = points_.back().key - first;
+  while ((range >> shift_) >= (uint64_t{1} << radix_bits)) {
+    shift_++;
+  }
+  const uint64_t max_prefix = range >> shift_;
+  radix_table_.resize(max_prefix + 2);
+  uint32_t next = 0;
+  for (uint64_t prefix = 0; prefix <= max_prefix + 1; prefix++) {
+    while (next < points_.size() &&
+           ((points_[next].key - first) >> shift_) < prefix) {
+      next++;
+    }
+    radix_table_[prefix] = next;
+  }
+}
+
+uint32_t RadixSplineModel::Predict(uint64_t key, uint32_t* max_error) const {
+  *max_error = max_error_;
+  if (key <= points_.front().key) {
+    return points_.front().position;
+  }
+  if (key >= points_.back().key) {
+    return points_.back().position;
+  }
+  // The first knot with a key >= "key" either shares its prefix or is the
+  // first knot with a larger one.
+  const uint64_t prefix = (key - points_.front().key) >> shift_;
+  const uint32_t begin = radix_table_[prefix];
+  const uint32_t end =
+      std::min<uint32_t>(radix_table_[prefix + 1], points_.size() - 1);
+  const auto next = std::lower_bound(
+      points_.begin() + begin, points_.begin() + end + 1, key,
+      [](const SplinePoint& point, uint64_t k) { return point.key < k; });
+  return InterpolateSpline(*(next - 1), *next, key);
+}
+
+}  // namespace leveldb
@@ -0,0 +1,128 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// RadixSpline: an error-bounded linear spline from sorted 64-bit keys to
+// their positions, built in a single pass, plus a radix table over the
+// top bits of the keys that narrows the search for a key's spline segment.
+
+#ifndef STORAGE_LEVELDB_UTIL_RADIX_SPLINE_H_
+#define STORAGE_LEVELDB_UTIL_RADIX_SPLINE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace leveldb {
+
+// A knot of a spline.  Knots have strictly increasing keys.
+struct SplinePoint {
+  uint64_t key;
+  uint32_t position;
+};
+
+// Returns the position the spline segment from "a" to "b" predicts for
+// "key", rounded down.  REQUIRES: a.key < key <= b.key
+inline uint32_t InterpolateSpline(const SplinePoint& a, const SplinePoint& b,
+                                  uint64_t key) {
+  const double fraction = static_cast<double>(key - a.key) /
+                          static_cast<double>(b.key - a.key);
+  return a.position +
+         static_cast<uint32_t>(fraction * (b.position - a.position));
+}
+
+// Returns the largest distance between the position the spline through
+// "points" predicts for keys[i] and i.
+// REQUIRES: "points" were built over "keys"
+uint32_t SplineError(const std::vector<SplinePoint>& points,
+                     const std::vector<uint64_t>& keys);
+
+// Most radix bits a RadixSplineModel can use, for a radix table of
+// 2^16 + 1 entries.
+constexpr int kMaxRadixBits = 16;
+
+// Returns the radix bits RadixSplineModel should index "num_points" knots
+// with: enough for about two table entries per knot, from 1 up to
+// kMaxRadixBits.
+int RadixBitsFor(size_t num_points);
+
+// Cuts a non-decreasing sequence of keys into spline segments with the
+// greedy spline corridor: the slopes from the last knot that keep every
+// key added since within "epsilon" positions of the line form a corridor,
+// and the previous key becomes a knot as soon as the next one falls
+// outside it.  Add() is O(1) and keeps no keys.  Runs of equal keys are
+// predicted at the position of their first key.
+class RadixSplineBuilder {
+ public:
+  explicit RadixSplineBuilder(uint32_t epsilon);
+
+  // Append the key at the next position.
+  // REQUIRES: key >= every previously added key
+  void Add(uint64_t key);
+
+  // Number of keys added so far.
+  size_t num_keys() const { return num_keys_; }
+
+  // Knots that no later key can move.
+  const std::vector<SplinePoint>& knots() const { return knots_; }
+
+  // The first occurrence of the last key added, which Finish() would
+  // make the final knot.  REQUIRES: num_keys() > 0
+  const SplinePoint& last_point() const { return last_; }
+
+  // Store the knots of the spline over the keys added so far in *points.
+  void Finish(std::vector<SplinePoint>* points) const;
+
+ private:
+  // Narrows the corridor from the last knot to keep "point" within
+  // epsilon_ positions of the line.
+  void Constrain(const SplinePoint& point);
+
+  uint32_t epsilon_;
+  size_t num_keys_;
+  std::vector<SplinePoint> knots_;
+  SplinePoint last_;
+  double lower_slope_;  // Corridor of feasible slopes from knots_.back()
+  double upper_slope_;
+};
+
+// A spline ready for lookups.  Knot i is found among the knots sharing
+// the top "radix_bits" bits of its distance from the first knot, which
+// the radix table maps to a range of knots.
+class RadixSplineModel {
+ public:
+  // An empty model, which must not be used for predictions.
+  RadixSplineModel() : shift_(0), max_error_(0) {}
+
+  // REQUIRES: "points" is non-empty with strictly increasing keys, and
+  // 1 <= radix_bits <= kMaxRadixBits
+  RadixSplineModel(std::vector<SplinePoint> points, int radix_bits,
+                   uint32_t max_error);
+
+  bool empty() const { return points_.empty(); }
+
+  const std::vector<SplinePoint>& points() const { return points_; }
+
+  // Returns the bytes of heap memory the model holds.
+  size_t ApproximateMemoryUsage() const {
+    return points_.capacity() * sizeof(SplinePoint) +
+           radix_table_.capacity() * sizeof(uint32_t);
+  }
+
+  // Returns the position the spline predicts for "key", and stores in
+  // *max_error how far predictions can be from a position.
+  // REQUIRES: !empty()
+  uint32_t Predict(uint64_t key, uint32_t* max_error) const;
+
+ private:
+  std::vector<SplinePoint> points_;
+  // radix_table_[p] is the first knot whose distance from the first knot
+  // is >= p << shift_.
+  std::vector<uint32_t> radix_table_;
+  int shift_;
+  uint32_t max_error_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_RADIX_SPLINE_H_
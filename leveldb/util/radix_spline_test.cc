@@ -0,0 +1,133 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "util/radix_spline.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "util/random.h"
+
+namespace leveldb {
+
+// Builds a spline over "keys" and checks that its knots are keys at their
+// first positions, that the measured error is within epsilon up to
+// rounding, and that a model over the knots predicts every key, and keys
+// between them, within that error.
+static std::vector<SplinePoint> Build(const std::vector<uint64_t>& keys,
+                                      uint32_t epsilon) {
+  RadixSplineBuilder builder(epsilon);
+  for (uint64_t key : keys) {
+    builder.Add(key);
+  }
+  EXPECT_EQ(keys.size(), builder.num_keys());
+  std::vector<SplinePoint> knots;
+  builder.Finish(&knots);
+  if (keys.empty()) {
+    EXPECT_TRUE(knots.empty());
+    return knots;
+  }
+
+  EXPECT_EQ(keys.front(), knots.front().key);
+  EXPECT_EQ(keys.back(), knots.back().key);
+  for (size_t i = 0; i < knots.size(); i++) {
+    EXPECT_EQ(keys[knots[i].position], knots[i].key);
+    if (knots[i].position > 0) {
+      EXPECT_LT(keys[knots[i].position - 1], knots[i].key);
+    }
+    if (i > 0) {
+      EXPECT_LT(knots[i - 1].key, knots[i].key);
+    }
+  }
+
+  const uint32_t max_error = SplineError(knots, keys);
+  bool duplicates = false;
+  for (size_t i = 1; i < keys.size(); i++) {
+    duplicates |= keys[i - 1] == keys[i];
+  }
+  if (!duplicates) {
+    EXPECT_LE(max_error, epsilon + 1);
+  }
+
+  for (int bits : {1, 4, RadixBitsFor(knots.size()), kMaxRadixBits}) {
+    const RadixSplineModel model(knots, bits, max_error);
+    for (uint32_t i = 0; i < keys.size(); i++) {
+      uint32_t error;
+      const uint32_t predicted = model.Predict(keys[i], &error);
+      EXPECT_EQ(max_error, error);
+      if (i == 0 || keys[i - 1] != keys[i]) {
+        EXPECT_LE(predicted, i + error) << "bits " << bits << " key " << i;
+        EXPECT_LE(i, predicted + error) << "bits " << bits << " key " << i;
+      }
+      if (i > 0 && keys[i - 1] + 1 < keys[i]) {
+        // A key between two others is predicted between them
+        const uint64_t between = keys[i - 1] + (keys[i] - keys[i - 1]) / 2;
+        const uint32_t p = model.Predict(between, &error);
+        EXPECT_LE(model.Predict(keys[i - 1], &error), p);
+        EXPECT_LE(p, model.Predict(keys[i], &error));
+      }
+    }
+  }
+  return knots;
+}
+
+TEST(RadixSplineTest, Empty) { Build({}, 4); }
+
+TEST(RadixSplineTest, Linear) {
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 1000; i++) {
+    keys.push_back(1000000 + i * 37);
+  }
+  ASSERT_EQ(2, Build(keys, 0).size());
+}
+
+TEST(RadixSplineTest, TwoSlopes) {
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 100; i++) {
+    keys.push_back(i * 2);
+  }
+  for (uint64_t i = 0; i < 100; i++) {
+    keys.push_back(1000 + i * 50);
+  }
+  ASSERT_LE(Build(keys, 0).size(), 4);
+}
+
+TEST(RadixSplineTest, Duplicates) {
+  std::vector<uint64_t> keys = {5, 5, 5, 5, 9, 9, 12};
+  ASSERT_EQ(3, Build(keys, 0).size());
+  Build({7, 7, 7}, 0);
+}
+
+TEST(RadixSplineTest, FullRange) {
+  std::vector<uint64_t> keys = {0, 1, 1ull << 40, 1ull << 62, ~0ull - 1,
+                                ~0ull};
+  Build(keys, 0);
+  Build(keys, 1);
+}
+
+TEST(RadixSplineTest, Skewed) {
+  Random rnd(301);
+  std::vector<uint64_t> keys;
+  uint64_t key = 0;
+  for (int i = 0; i < 2000; i++) {
+    // Mostly dense runs broken up by occasional large gaps
+    key += 1 + (rnd.OneIn(20) ? rnd.Uniform(1 << 30) : rnd.Uniform(8));
+    keys.push_back(key);
+  }
+  size_t last_count = keys.size() + 1;
+  for (uint32_t epsilon : {0, 1, 4, 16, 64}) {
+    const size_t count = Build(keys, epsilon).size();
+    ASSERT_LT(count, last_count) << "epsilon " << epsilon;
+    last_count = count;
+  }
+}
+
+TEST(RadixSplineTest, RadixBits) {
+  ASSERT_EQ(1, RadixBitsFor(1));
+  ASSERT_EQ(2, RadixBitsFor(2));
+  ASSERT_EQ(5, RadixBitsFor(10));
+  ASSERT_EQ(kMaxRadixBits, RadixBitsFor(1 << 20));
+}
+
+}  // namespace leveldb
@@ -4,6 +4,10 @@
 
 #include "util/testutil.h"
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <random>
 #include <string>
 
 #include "util/random.h"
@@ -47,5 +51,121 @@ Slice CompressibleString(Random* rnd, double compressed_fraction, size_t len,
   return Slice(*dst);
 }
 
+namespace {
+
+// Appends to *keys the running sums of "n" gaps drawn by "gap", starting
+// from a random base.
+template <typename GapFn>
+void AppendGaps(std::mt19937_64* rng, int n, GapFn gap,
+                std::vector<uint64_t>* keys) {
+  uint64_t key = (*rng)() % (kMaxGeneratedKey / 1000);
+  for (int i = 0; i < n; i++) {
+    key += std::max<uint64_t>(1, gap());
+    keys->push_back(key);
+  }
+}
+
+}  // namespace
+
+bool GenerateKeys(const std::string& distribution, uint64_t seed, int n,
+                  std::vector<uint64_t>* keys) {
+  std::mt19937_64 rng(seed);
+  const double kMax = static_cast<double>(kMaxGeneratedKey - 1);
+  keys->clear();
+  // Distributions of key values draw until they have n distinct keys;
+  // distributions of gaps add up n gaps.
+  std::function<double()> draw;
+  if (distribution == "uniform") {
+    std::uniform_real_distribution<double> d(0, kMax);
+    draw = [&rng, d]() mutable { return d(rng); };
+  } else if (distribution == "normal") {
+    std::normal_distribution<double> d(kMax / 2, kMax / 10);
+    draw = [&rng, d]() mutable { return d(rng); };
+  } else if (distribution == "lognormal") {
+    // As in SOSD: exp(N(0, 2)), scaled up to integers
+    std::lognormal_distribution<double> d(0, 2);
+    draw = [&rng, d]() mutable { return d(rng) * 1e9; };
+  } else if (distribution == "zipf") {
+    // Clusters of a million key values at random places; the i-th largest
+    // cluster holds about 1/i of the keys of the largest.
+    const int kClusters = 1000;
+    std::vector<double> centers(kClusters), weights(kClusters);
+    std::uniform_real_distribution<double> place(0, kMax - 1e6);
+    for (int i = 0; i < kClusters; i++) {
+      centers[i] = place(rng);
+      weights[i] = 1.0 / (i + 1);
+    }
+    std::discrete_distribution<int> cluster(weights.begin(), weights.end());
+    std::uniform_real_distribution<double> offset(0, 1e6);
+    draw = [&rng, centers, cluster, offset]() mutable {
+      return centers[cluster(rng)] + offset(rng);
+    };
+  } else if (distribution == "piecewise") {
+    // Runs of up to 10000 keys, each with gaps of about 1, 100, 10^4 or
+    // 10^6
+    std::uniform_int_distribution<int> length(1, 10000);
+    std::uniform_int_distribution<int> scale(0, 3);
+    while (static_cast<int>(keys->size()) < n) {
+      const int run = std::min<int>(length(rng), n - keys->size());
+      static const uint64_t kMeans[] = {1, 100, 10000, 1000000};
+      const uint64_t mean = kMeans[scale(rng)];
+      std::uniform_int_distribution<uint64_t> gap(1, 2 * mean);
+      uint64_t key = keys->empty() ? 0 : keys->back();
+      for (int i = 0; i < run; i++) {
+        key += gap(rng);
+        keys->push_back(key);
+      }
+    }
+  } else if (distribution == "books") {
+    // Smooth: lognormal gaps of a few hundred
+    std::lognormal_distribution<double> d(5, 1);
+    AppendGaps(&rng, n, [&rng, &d]() { return d(rng); }, keys);
+  } else if (distribution == "fb") {
+    // Mostly small gaps with rare gaps of up to 10^12
+    std::geometric_distribution<uint64_t> small(0.01);
+    std::uniform_real_distribution<double> coin(0, 1);
+    std::uniform_int_distribution<uint64_t> huge(1, 1000000000000ull);
+    AppendGaps(&rng, n,
+               [&]() { return coin(rng) < 1e-4 ? huge(rng) : small(rng); },
+               keys);
+  } else if (distribution == "osm") {
+    // Dense runs of cell ids, gaps of 1 to 4, broken by jumps to the next
+    // occupied region
+    std::uniform_int_distribution<uint64_t> step(1, 4);
+    std::uniform_real_distribution<double> coin(0, 1);
+    std::lognormal_distribution<double> jump(12, 2);
+    AppendGaps(&rng, n,
+               [&]() {
+                 return coin(rng) < 0.01 ? static_cast<uint64_t>(jump(rng))
+                                         : step(rng);
+               },
+               keys);
+  } else {
+    return false;
+  }
+
+  if (draw) {
+    while (static_cast<int>(keys->size()) < n) {
+      for (int i = keys->size(); i < n; i++) {
+        const double key = draw();
+        keys->push_back(static_cast<uint64_t>(
+            std::min(kMax, std::max(0.0, std::floor(key)))));
+      }
+      std::sort(keys->begin(), keys->end());
+      keys->erase(std::unique(keys->begin(), keys->end()), keys->end());
+    }
+  } else if (!keys->empty() && keys->back() >= kMaxGeneratedKey) {
+    // Scale the keys down into range, keeping them distinct
+    const double scale = kMax / keys->back();
+    uint64_t last = 0;
+    for (size_t i = 0; i < keys->size(); i++) {
+      uint64_t key = static_cast<uint64_t>((*keys)[i] * scale);
+      if (i > 0 && key <= last) key = last + 1;
+      (*keys)[i] = last = key;
+    }
+  }
+  return true;
+}
+
 }  // namespace test
 }  // namespace leveldb
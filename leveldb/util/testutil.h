@@ -5,6 +5,10 @@
 #ifndef STORAGE_LEVELDB_UTIL_TESTUTIL_H_
 #define STORAGE_LEVELDB_UTIL_TESTUTIL_H_
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "helpers/memenv/memenv.h"
@@ -43,6 +47,18 @@ std::string RandomKey(Random* rnd, int len);
 Slice CompressibleString(Random* rnd, double compressed_fraction, size_t len,
                          std::string* dst);
 
+// Keys GenerateKeys() makes stay below this bound, so that they print in
+// 15 decimal digits.
+constexpr uint64_t kMaxGeneratedKey = 1000000000000000ull;
+
+// Stores in *keys "n" distinct keys below kMaxGeneratedKey drawn from
+// "distribution" with "seed", in order: uniform, normal, lognormal, zipf
+// (clusters of keys with zipfian sizes), piecewise (runs of keys with their
+// own density each), or books, fb and osm (gaps between keys shaped like
+// those SOSD datasets).  Returns false if the distribution is unknown.
+bool GenerateKeys(const std::string& distribution, uint64_t seed, int n,
+                  std::vector<uint64_t>* keys);
+
 // A wrapper that allows injection of errors.
 class ErrorEnv : public EnvWrapper {
  public:
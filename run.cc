@@ -8,15 +8,21 @@
 #include "leveldb/write_batch.h"
 #include "leveldb/cache.h"
 #include "leveldb/filter_policy.h"
+#include "leveldb/key_projection.h"
 
 
 using namespace std;
 
-int main(void) 
+int main(int argc, char** argv) 
 {
     leveldb::DB *db;
     leveldb::Options options;
     options.create_if_missing = true;
+    options.key_projection = leveldb::NewDecimalKeyProjection();
+    // pass "slr" to build the tables with the SLR search model
+    if (argc > 1 && string(argv[1]) == "slr") {
+        options.block_search_mode = leveldb::kSLRSearch;
+    }
 	// options.filter_policy = leveldb::NewBloomFilterPolicy(10);
     // open
     // leveldb::Status status = leveldb::DB::Open(options, "dbonly/test2", &db); 
@@ -136,6 +142,7 @@ int main(void)
    
 	
     delete db;
+    delete options.key_projection;
     
     return 0;
 }
\ No newline at end of file